@@ -3,27 +3,133 @@ Este programa compara archivos de texto en una carpeta llamada "dataset"
 y genera un archivo HTML que muestra los pares de documentos más similares,
 resaltando las subcadenas comunes entre ellos. Utiliza tres métricas para 
 evaluar la similitud: 
-1. Similitud basada en subcadenas comunes.
+1. Similitud basada en subcadenas comunes: por defecto (--similarity mass) la
+   suma de las longitudes de las subcadenas comunes distintas entre la longitud
+   del texto más largo, que cuenta cada sufijo y prefijo de una coincidencia
+   larga y puede pasar de 1; con --similarity coverage, la fracción de los
+   caracteres de ambos textos cubiertos por coincidencias de longitud >= k,
+   entre 0 y 1 y en tiempo lineal con el autómata de sufijos.
 2. Distancia de edición (Levenshtein).
 3. Contención de Broder.
 Complejidad temporal:
 - La generación de la matriz de similitud es O(n^2 * m * k), donde n es 
   el número de documentos, m es la longitud promedio de los documentos, 
-  y k es la longitud mínima de las subcadenas comunes.
+  y k es la longitud mínima de las subcadenas comunes. Los pares se reparten
+  entre --threads N hilos con robo de trabajo. Un índice invertido de
+  k-gramas descarta los pares sin ningún k-grama en común (similitud 0), de
+  modo que el costo depende del número de pares que realmente se traslapan.
+  Con --min-shared N > 1 el índice usa el filtro de prefijos de PPJoin (sólo
+  los |S| - N + 1 shingles menos frecuentes de cada documento) y verifica la
+  intersección exacta. Con --similarity coverage cada candidato se acota por
+  sus longitudes y los shingles que comparte, y se omite sin leerlo si la cota
+  no alcanza al peor de los K mejores del hilo (que sube durante la ejecución)
+  ni el umbral de la matriz dispersa.
+  Con --block-rows R la matriz se recorre por bloques de R filas contra
+  bloques de columnas que caben en la caché (--block-cache KiB, por defecto
+  la mitad de la L2): cada bloque de columnas se lee una vez por bloque de
+  filas en lugar de una vez por fila.
+- Con --lsh BxR sólo se evalúan los pares que coinciden en alguna banda de sus
+  firmas MinHash y se conservan los mejores en un montículo acotado, sin
+  ordenar los n(n-1)/2 pares; --lsh-sample S estima el recall contra el modo
+  exacto sobre una muestra de S documentos.
 - La distancia de edición tiene una complejidad de O(a * b), donde a y b 
-  son las longitudes de los dos textos a comparar.
-- La contención de Broder es O(m * n) para calcular las subcadenas.
+  son las longitudes de los dos textos a comparar, con memoria O(min(a, b)).
+  Con --max-edit T se usa la banda de Ukkonen, O(T * min(a, b)), que termina
+  en cuanto la distancia supera T (T >= 0; con 0 sólo se detectan las copias
+  exactas). Por defecto se usa el núcleo bit-paralelo de Myers/Hyyrö,
+  O(a * b / 64), con variantes AVX2/AVX-512 elegidas en tiempo
+  de ejecución; --verify-edit compara todas las variantes contra la DP.
+- La contención de Broder original es O(m^2) cadenas por documento; ahora se
+  estima con bocetos MinHash bottom-k de k-shingles calculados una vez por
+  documento, con costo O(s) por par (s = tamaño del boceto). El valor exacto
+  sobre k-shingles (--containment exact) y el original (--containment legacy)
+  siguen disponibles; --validate-sketch compara boceto contra valor exacto.
+  Los shingles se obtienen con un hash rodante (Rabin-Karp) en una pasada,
+  O(m) en lugar de O(m * k), con una variante AVX-512 de 8 carriles;
+  --bench-shingles la compara con el unordered_set<string> original.
+- La contención original y el motor DP deduplican las subcadenas en conjuntos
+  planos de huellas de 64 bits (8 bytes por subcadena, sin nodos ni copias);
+  --verify-spans guarda además el intervalo y compara el texto si dos
+  huellas coinciden.
+- --stats muestra al final el tiempo de cada fase (carga, evaluación de pares,
+  exportación, reporte, distancias de edición y contenciones), los pares
+  evaluados y descartados, los bytes leídos, las celdas DP, el pico de memoria
+  residente y de la arena y el tiempo ocupado de cada hilo; --stats-json los
+  escribe en JSON. Los contadores se suman una vez por tabla o por par; los
+  pares de la muestra de --lsh-sample se cuentan aparte.
+- --bench mide cada núcleo sobre textos sintéticos de longitud creciente (y la
+  matriz sobre corpus de tamaño creciente) con una proporción de plagio
+  controlada (--bench-rate) e informa el exponente de escalado; --bench-csv
+  guarda las curvas y --bench-filter elige los núcleos.
+- Con el motor de autómata de sufijos (opción por defecto, --backend sam) las
+  subcadenas comunes de un par se obtienen en O((a + b) log a) en lugar de
+  O(a * b); la tabla DP original sigue disponible con --backend dp. Las
+  transiciones de la raíz del autómata van en una tabla directa por símbolo
+  (especializada para bytes y para identificadores de token), porque el
+  recorrido vuelve a ella tras cada discrepancia y con tokens tiene casi todo
+  el vocabulario del documento.
+- Con --tokens el texto se normaliza (minúsculas, espacios colapsados, sin
+  puntuación y, con --stopwords ARCHIVO, sin palabras vacías) y cada documento
+  se convierte en una secuencia de identificadores de palabra. Todas las
+  métricas se calculan sobre esa secuencia, unas 5 veces más corta que el
+  texto, y los shingles son k palabras; --keep-case y --keep-punctuation
+  desactivan partes de la normalización. El reporte resalta el texto original.
 
 Complejidad espacial:
-- O(n) para almacenar los documentos.
-- O(n^2) para la matriz de similitud.
-- O(m * n) para las estructuras temporales usadas en la distancia de edición 
-  y la contención de Broder.
+- O(n) para almacenar los documentos, que se proyectan en memoria con mmap y
+  se recorren como string_view sin copiar su contenido.
+- O(K * hilos) para los K mejores pares (--top K), que se seleccionan con un
+  montículo acotado por hilo mientras se genera la matriz.
+- La matriz completa sólo se guarda si se pide con --storage: como triángulo
+  superior de float (n(n-1)/2 valores) o, a partir de 10000 documentos o con
+  --storage sparse, como matriz dispersa CSR con los pares mayores que
+  --threshold.
+- O(m) para la distancia de edición (dos filas de la tabla DP) y O(s) por
+  documento para los bocetos de la contención de Broder.
+- La memoria temporal de cada par (filas DP, tablas de Myers, conjuntos de
+  subcadenas) sale de una arena monótona por hilo que se rebobina al terminar
+  el par; --stats muestra el pico de la arena.
+
+Entrada:
+Por defecto se leen todos los archivos de la carpeta "dataset"; --dir, --recursive
+y --glob cambian la carpeta, el recorrido y el patrón de nombres. La carga usa
+hilos lectores y una cola acotada hacia los hilos que calculan las huellas.
+Con --query DIR sólo se evalúan los pares entre las entregas nuevas de DIR y
+el resto del corpus, O(nuevos * n), y con --top-store ARCHIVO los resultados
+se combinan con los mejores pares guardados en ejecuciones anteriores, que
+deben tener los mismos parámetros; los pares con documentos modificados
+desde entonces se vuelven a calcular.
+Con --cache ARCHIVO las huellas (shingles, bocetos y firmas) se guardan en un
+archivo binario versionado indexado por el hash del contenido, y en las
+siguientes ejecuciones sólo se procesan los documentos nuevos o modificados.
+Con --shard i/N --shard-output ARCHIVO el corpus se divide en bloques contiguos
+de documentos (--shard-memory MiB por par de bloques o --tile-size N documentos
+por bloque) y el nodo i evalúa uno de cada N bloques del triángulo superior,
+cargando sólo los dos bloques de documentos de cada uno. Cada nodo guarda sus
+mejores pares (y, con --export-all, los que superan --threshold) en un archivo
+parcial, y --merge ARCHIVO (una vez por parcial) los combina por ruta y genera
+el reporte y la exportación como una ejecución completa. El parcial registra
+--top y --threshold: --merge rechaza un --top mayor o un umbral distinto.
+
+Salida:
+El reporte similar_texts.html se escribe par por par a través de un búfer
+grande. Con --split-report DIR los textos resaltados de cada par se guardan en
+DIR/par_K.html y la página principal sólo los enlaza y los carga al abrirlos.
+--html ARCHIVO cambia su ruta y --no-html lo omite. Con --export ARCHIVO los
+pares del reporte (o, con --export-all, todos los pares de la matriz guardada
+por --storage que superan --threshold) se exportan con sus métricas y
+coincidencias maximales en JSON Lines o, con --export-format binary, en un
+archivo binario por columnas. Las métricas cuestan una distancia de edición y
+un recorrido del autómata por par; con millones de pares de --export-all,
+--export-metrics similarity exporta sólo la similitud, sin ese costo.
 
 Ejecución:
 Dado el uso de algunas funciones Lambda, el código a ejecutar para el compilado es el siguiente:
-    g++ -std=c++17 -lstdc++fs -o plagiarism_detector main.cpp
+    g++ -std=c++17 -O2 -pthread -o plagiarism_detector main.cpp -lstdc++fs
 Probado en un procesador i7 13650hx, tardó cerca de 1 minuto en compilar.  
+Para usar el detector dentro de otro programa, plagiarism_detector.h declara la API de
+biblioteca (Detector, con carga del corpus, evaluación asíncrona con avance y cancelación);
+compilando main.cpp con -DPLAGIARISM_DETECTOR_NO_MAIN se obtiene la biblioteca sin la función main.
  */
 
 #include <iostream>          // Librería para flujo de entrada/salida
@@ -34,202 +140,5175 @@ Probado en un procesador i7 13650hx, tardó cerca de 1 minuto en compilar.
 #include <iomanip>           // Librería para controlar la precisión de la salida
 #include <filesystem>        // Librería para operaciones con archivos y carpetas (C++17)
 #include <unordered_set>     // Librería para el contenedor unordered_set
-#include <sstream>           // Librería para usar stringstream
+#include <cstdint>           // Librería para enteros de tamaño fijo (uint64_t)
+#include <cstdlib>           // Librería para strtol
+#include <cmath>             // Librería para fabs
+#include <iterator>          // Librería para back_inserter
+#include <random>            // Librería para generar cadenas de prueba en --verify-edit
+#include <thread>            // Librería para hilos de ejecución
+#include <mutex>             // Librería para exclusión mutua entre hilos
+#include <deque>             // Librería para las colas del planificador
+#include <functional>        // Librería para std::function
+#include <memory>            // Librería para unique_ptr
+#include <atomic>            // Librería para contadores compartidos entre hilos
+#include <condition_variable> // Librería para la cola acotada de la ingesta
+#include <string_view>       // Librería para vistas de cadenas sin copia
+#include <cstring>           // Librería para memcpy y memcmp
+#include <unordered_map>     // Librería para la caché de huellas
+#include <cctype>            // Librería para isalnum y tolower (normalización)
+#include <chrono>            // Librería para medir tiempos en las pruebas de rendimiento
+#include <optional>          // Librería para las métricas de un par calculadas bajo demanda
+#include <numeric>           // Librería para iota
+#include <limits>            // Librería para numeric_limits (cotas de similitud)
+#include <future>            // Librería para los trabajos asíncronos de la API de biblioteca
+
+#include "plagiarism_detector.h" // API de biblioteca (Detector, ScoringJob)
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAVE_MMAP 1          // Proyección de archivos en memoria (POSIX)
+#include <sys/mman.h>        // mmap, munmap, madvise
+#include <sys/stat.h>        // fstat
+#include <fcntl.h>           // open
+#include <unistd.h>          // close
+#include <sys/resource.h>    // getrusage, para el pico de memoria residente
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HAVE_X86_SIMD 1      // Núcleos AVX2/AVX-512 con despacho en tiempo de ejecución
+#include <immintrin.h>       // Intrínsecos de AVX2 y AVX-512
+#endif
 
 using namespace std;         // Espacio de nombres estándar
+
+// El motor vive en plagiarism::detail para que, compilado como biblioteca, sus nombres no choquen
+// con los del programa que lo usa; la API pública está en plagiarism_detector.h
+namespace plagiarism {
+namespace detail {
+
 namespace fs = std::filesystem; // Alias para filesystem, para simplificar
 
-// Función para leer el contenido completo de un archivo
-string readFile(const string &filename) {
-    ifstream file(filename);         // Abrimos el archivo de entrada
-    stringstream buffer;             // Creamos un buffer de stringstream
-    buffer << file.rdbuf();          // Leemos el contenido del archivo en el buffer
-    return buffer.str();             // Devolvemos el contenido completo como una cadena
+// Estadísticas de la ejecución (--stats): tiempos por fase y contadores. Todo se acumula con sumas
+// atómicas relajadas una vez por tabla, par o tarea (nunca por celda), así que cuesta lo mismo
+// tenerlas siempre activas; sólo se muestran o se escriben si se piden
+struct RunStats {
+    enum Phase {
+        Load,          // Lectura del corpus y cálculo de huellas
+        Score,         // Evaluación de los pares (matriz, LSH o modo incremental)
+        Export,        // Exportación de los pares
+        Report,        // Reporte HTML
+        EditDistance,  // Distancias de edición de los pares exportados o del reporte (suma entre hilos)
+        Containment,   // Contenciones de Broder de esos pares (suma entre hilos)
+        PhaseCount
+    };
+
+    atomic<uint64_t> phaseNanos[PhaseCount] = {}; // Tiempo acumulado de cada fase
+    atomic<uint64_t> pairsScored{0};   // Pares con similitud calculada
+    atomic<uint64_t> samplePairsScored{0}; // Pares de la muestra de --lsh-sample (aparte de los anteriores)
+    atomic<uint64_t> pairsPruned{0};   // Pares descartados por el índice de shingles o por LSH
+    atomic<uint64_t> bytesRead{0};     // Bytes de los archivos leídos
+    atomic<uint64_t> dpCells{0};       // Celdas evaluadas de las tablas DP (Myers las evalúa de 64 en 64)
+
+    // Suma `seconds` al tiempo ocupado del hilo `worker` del planificador
+    void addBusy(int worker, double seconds) {
+        lock_guard<mutex> guard(busyLock);
+        if (busySeconds.size() <= static_cast<size_t>(worker)) busySeconds.resize(worker + 1, 0.0);
+        busySeconds[worker] += seconds;
+    }
+
+    vector<double> busy() {
+        lock_guard<mutex> guard(busyLock);
+        return busySeconds;
+    }
+
+private:
+    mutex busyLock;                    // Protege busySeconds; se toma una vez por hilo y ejecución
+    vector<double> busySeconds;        // Tiempo ocupado de cada hilo del planificador
+};
+
+// Estadísticas globales del proceso
+RunStats &runStats() {
+    static RunStats stats;
+    return stats;
+}
+
+// Función para sumar a un contador de las estadísticas
+inline void countStat(atomic<uint64_t> &counter, uint64_t amount) {
+    counter.fetch_add(amount, memory_order_relaxed);
+}
+
+// Temporizador de alcance: suma a la fase el tiempo hasta su destrucción o hasta stop()
+class ScopedTimer {
+public:
+    explicit ScopedTimer(RunStats::Phase phase) : phase(phase), start(chrono::steady_clock::now()) {}
+    ~ScopedTimer() { stop(); }
+
+    void stop() {
+        if (stopped) return;
+        stopped = true;
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        countStat(runStats().phaseNanos[phase], elapsed.count());
+    }
+
+private:
+    RunStats::Phase phase;
+    chrono::steady_clock::time_point start;
+    bool stopped = false;
+};
+
+// Función para obtener el pico de memoria residente del proceso en KiB (0 si no se puede medir)
+size_t peakResidentKiB() {
+#ifdef HAVE_MMAP
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;     // macOS informa bytes
+#else
+        return usage.ru_maxrss;            // Linux informa KiB
+#endif
+    }
+#endif
+    return 0;
+}
+
+// Archivo proyectado en memoria de sólo lectura. El contenido se expone como string_view sin
+// copiarlo; si mmap no está disponible o falla, se lee a un buffer propio
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept { *this = move(other); }
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            unmap();
+            mapped = other.mapped;
+            mappedSize = other.mappedSize;
+            fallback = move(other.fallback);
+            other.mapped = nullptr;
+            other.mappedSize = 0;
+        }
+        return *this;
+    }
+    ~MappedFile() { unmap(); }
+
+    // Proyecta el archivo `filename`; devuelve false si no se pudo abrir o no es un archivo regular
+    bool open(const string &filename) {
+        unmap();
+        fallback.clear();
+#ifdef HAVE_MMAP
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        bool stated = fstat(fd, &info) == 0;
+        if (stated && !S_ISREG(info.st_mode)) {
+            ::close(fd);                   // Una carpeta se abre, pero no tiene contenido que leer
+            return false;
+        }
+        if (stated && info.st_size > 0) {
+            void *address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                mapped = static_cast<const char *>(address);
+                mappedSize = info.st_size;
+                madvise(address, mappedSize, MADV_SEQUENTIAL); // Los núcleos recorren el texto en orden
+                ::close(fd);
+                return true;
+            }
+        } else if (stated) {
+            ::close(fd);                   // Archivo regular vacío: no hay nada que proyectar
+            return true;
+        }
+        ::close(fd);
+#endif
+        ifstream file(filename, ios::binary); // Respaldo: lectura directa a un buffer propio
+        if (!file) {
+            return false;
+        }
+        fallback.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        return true;
+    }
+
+    string_view view() const {
+        return mapped != nullptr ? string_view(mapped, mappedSize) : string_view(fallback);
+    }
+
+private:
+    const char *mapped = nullptr;  // Dirección de la proyección, o nulo
+    size_t mappedSize = 0;         // Tamaño de la proyección
+    string fallback;               // Contenido leído cuando no se usa mmap
+
+    void unmap() {
+#ifdef HAVE_MMAP
+        if (mapped != nullptr) {
+            munmap(const_cast<char *>(mapped), mappedSize);
+        }
+#endif
+        mapped = nullptr;
+        mappedSize = 0;
+    }
+};
+
+// Función para leer el contenido completo de un archivo sin copiarlo (proyección en memoria). Si se
+// da `opened`, recibe si se pudo abrir y quien llama informa el error; si no, se informa en cerr
+MappedFile readFile(const string &filename, bool *opened = nullptr) {
+    MappedFile file;
+    bool ok = file.open(filename);   // Abrimos y proyectamos el archivo de entrada
+    if (opened != nullptr) {
+        *opened = ok;
+    } else if (!ok) {
+        cerr << "No se pudo leer " << filename << endl;
+    }
+    countStat(runStats().bytesRead, file.view().size());
+    return file;                     // El contenido se consulta con view()
+}
+
+// Arena monótona: la memoria temporal de las métricas de un par se toma de bloques grandes con un
+// simple avance de puntero y se libera toda junta al salir del alcance (ArenaScope), en lugar de
+// una reserva y liberación de malloc por tabla, fila o nodo. Los bloques se conservan entre pares
+class MonotonicArena {
+public:
+    // Posición de la arena, para volver a ella al terminar un alcance
+    struct Mark {
+        size_t chunk;   // Bloque actual
+        size_t offset;  // Bytes usados del bloque actual
+        size_t used;    // Bytes usados en total
+    };
+
+    MonotonicArena() = default;
+    MonotonicArena(const MonotonicArena &) = delete;
+    MonotonicArena &operator=(const MonotonicArena &) = delete;
+    ~MonotonicArena() { publishPeak(); }
+
+    void *allocate(size_t bytes, size_t alignment) {
+        size_t start = (offset + alignment - 1) & ~(alignment - 1);
+        if (chunks.empty() || start + bytes > chunks[current].size) {
+            nextChunk(bytes + alignment);
+            start = (offset + alignment - 1) & ~(alignment - 1);
+        }
+        used += start - offset + bytes;
+        offset = start + bytes;
+        peak = max(peak, used);
+        return chunks[current].data.get() + start;
+    }
+
+    Mark mark() const { return {current, offset, used}; }
+
+    // Libera todo lo reservado después de `position`; los bloques quedan para reutilizarse
+    void rewind(const Mark &position) {
+        current = position.chunk;
+        offset = position.offset;
+        used = position.used;
+        if (used == 0) {
+            publishPeak();                     // Fin de un alcance externo: actualizamos la estadística
+        }
+    }
+
+    // Máximo de bytes en uso a la vez en cualquier arena del proceso
+    static size_t globalPeak() { return peakBytes.load(); }
+
+private:
+    struct Chunk {
+        unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    static const size_t minimumChunk = 1 << 20; // Bloques de al menos 1 MiB
+    static inline atomic<size_t> peakBytes{0};
+
+    vector<Chunk> chunks;     // Bloques reservados, en orden de uso
+    size_t current = 0;       // Bloque del que se está tomando memoria
+    size_t offset = 0;        // Bytes usados del bloque actual
+    size_t used = 0;          // Bytes en uso (incluye el relleno de alineación)
+    size_t peak = 0;          // Máximo de `used` en esta arena
+
+    // Pasa al siguiente bloque con al menos `bytes` libres, reservándolo si hace falta
+    void nextChunk(size_t bytes) {
+        if (!chunks.empty()) {
+            used += chunks[current].size - offset; // El final del bloque anterior queda sin usar
+            current++;
+        }
+        if (current == chunks.size() || chunks[current].size < bytes) {
+            size_t size = max({minimumChunk, bytes, chunks.empty() ? 0 : 2 * chunks.back().size});
+            chunks.insert(chunks.begin() + current, Chunk{unique_ptr<char[]>(new char[size]), size});
+        }
+        offset = 0;
+    }
+
+    void publishPeak() {
+        size_t known = peakBytes.load();
+        while (peak > known && !peakBytes.compare_exchange_weak(known, peak)) {
+        }
+    }
+};
+
+// Función para obtener la arena del hilo actual; cada hilo del planificador tiene la suya
+MonotonicArena &threadArena() {
+    thread_local MonotonicArena arena;
+    return arena;
 }
 
-// Función para encontrar todas las subcadenas comunes de al menos `minLength` entre dos cadenas
-vector<string> findCommonSubstrings(const string &str1, const string &str2, int minLength) {
-    unordered_set<string> substrings;          // Set para almacenar subcadenas únicas comunes
+// Alcance de la arena: todo lo que se reserva mientras existe se libera al destruirlo
+class ArenaScope {
+public:
+    explicit ArenaScope(MonotonicArena &arena = threadArena()) : arena(arena), position(arena.mark()) {}
+    ~ArenaScope() { arena.rewind(position); }
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    MonotonicArena &get() { return arena; }
+
+private:
+    MonotonicArena &arena;
+    MonotonicArena::Mark position;
+};
+
+// Asignador de la biblioteca estándar sobre una arena: deallocate no hace nada, la memoria se
+// recupera al cerrar el alcance
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(MonotonicArena &arena = threadArena()) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t count) { return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T *, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+
+    MonotonicArena *arena;
+};
+
+template <typename T>
+using ArenaVector = vector<T, ArenaAllocator<T>>;
+
+// Función para mezclar los bits de un hash de 64 bits (finalizador de splitmix64)
+uint64_t mixHash(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Función para calcular el hash de 64 bits de los `bytes` bytes de un shingle (FNV-1a con mezcla final)
+uint64_t hashShingle(const char *data, size_t bytes) {
+    uint64_t hash = 0xcbf29ce484222325ULL;         // Base de FNV-1a
+    for (size_t i = 0; i < bytes; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;                  // Primo de FNV-1a
+    }
+    return mixHash(hash);                          // Distribución uniforme para MinHash
+}
+
+// Conjunto plano de subcadenas de un texto base guardadas como intervalos (inicio, longitud):
+// direccionamiento abierto con sondeo lineal sobre memoria de la arena, sin copiar ni poseer
+// cadenas. El llamador da el hash de cada subcadena para poder calcularlo de forma incremental
+template <typename CharT>
+class SpanHashSet {
+public:
+    SpanHashSet(basic_string_view<CharT> text, size_t expected, MonotonicArena &arena = threadArena())
+        : text(text), slots(ArenaAllocator<Slot>(arena)) {
+        size_t capacity = 16;
+        while (capacity < 2 * expected) capacity *= 2;
+        slots.assign(capacity, Slot{0, 0, 0});
+    }
+
+    // Inserta text.substr(start, length) (length > 0); devuelve false si ya estaba
+    bool insert(uint64_t hash, size_t start, size_t length) {
+        if (2 * (count + 1) > slots.size()) grow();
+        basic_string_view<CharT> value = text.substr(start, length);
+        for (size_t s = hash & (slots.size() - 1);; s = (s + 1) & (slots.size() - 1)) {
+            if (slots[s].length == 0) {
+                slots[s] = {hash, static_cast<uint32_t>(start), static_cast<uint32_t>(length)};
+                count++;
+                return true;
+            }
+            if (slots[s].hash == hash && text.substr(slots[s].start, slots[s].length) == value) {
+                return false;
+            }
+        }
+    }
+
+    bool contains(uint64_t hash, basic_string_view<CharT> value) const {
+        for (size_t s = hash & (slots.size() - 1); slots[s].length != 0; s = (s + 1) & (slots.size() - 1)) {
+            if (slots[s].hash == hash && text.substr(slots[s].start, slots[s].length) == value) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t size() const { return count; }
+
+    // Llama visit(hash, subcadena) para cada elemento
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const auto &slot : slots) {
+            if (slot.length != 0) visit(slot.hash, text.substr(slot.start, slot.length));
+        }
+    }
+
+private:
+    struct Slot {
+        uint64_t hash;     // Hash de la subcadena
+        uint32_t start;    // Inicio en el texto base
+        uint32_t length;   // Longitud (0 = casilla vacía)
+    };
+
+    basic_string_view<CharT> text;
+    ArenaVector<Slot> slots;
+    size_t count = 0;
+
+    void grow() {
+        ArenaVector<Slot> old(slots.size() * 2, Slot{0, 0, 0}, slots.get_allocator());
+        old.swap(slots);
+        for (const auto &slot : old) {
+            if (slot.length == 0) continue;
+            size_t s = slot.hash & (slots.size() - 1);
+            while (slots[s].length != 0) s = (s + 1) & (slots.size() - 1);
+            slots[s] = slot;
+        }
+    }
+};
+
+// Conjunto plano de huellas de 64 bits con direccionamiento abierto y sondeo lineal: 8 bytes por
+// elemento en un único bloque de la arena. Dos subcadenas distintas con la misma huella se toman por
+// iguales (probabilidad ~2^-64 por par); SpanHashSet hace la verificación exacta cuando se pide
+class FingerprintSet {
+public:
+    FingerprintSet(size_t expected, MonotonicArena &arena = threadArena()) : slots(ArenaAllocator<uint64_t>(arena)) {
+        size_t capacity = 16;
+        while (capacity < 2 * expected) capacity *= 2;
+        slots.assign(capacity, 0);
+    }
+
+    // Inserta la huella; devuelve false si ya estaba
+    bool insert(uint64_t hash) {
+        if (2 * (count + 1) > slots.size()) grow();
+        hash = nonZero(hash);
+        for (size_t s = hash & (slots.size() - 1);; s = (s + 1) & (slots.size() - 1)) {
+            if (slots[s] == 0) {
+                slots[s] = hash;
+                count++;
+                return true;
+            }
+            if (slots[s] == hash) return false;
+        }
+    }
+
+    bool contains(uint64_t hash) const {
+        hash = nonZero(hash);
+        for (size_t s = hash & (slots.size() - 1); slots[s] != 0; s = (s + 1) & (slots.size() - 1)) {
+            if (slots[s] == hash) return true;
+        }
+        return false;
+    }
+
+    size_t size() const { return count; }
+
+    // Llama visit(huella) para cada elemento
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (uint64_t slot : slots) {
+            if (slot != 0) visit(slot);
+        }
+    }
+
+private:
+    ArenaVector<uint64_t> slots;               // 0 marca una casilla vacía
+    size_t count = 0;
+
+    static uint64_t nonZero(uint64_t hash) { return hash != 0 ? hash : 1; }
+
+    void grow() {
+        ArenaVector<uint64_t> old(slots.size() * 2, 0, slots.get_allocator());
+        old.swap(slots);
+        for (uint64_t slot : old) {
+            if (slot == 0) continue;
+            size_t s = slot & (slots.size() - 1);
+            while (slots[s] != 0) s = (s + 1) & (slots.size() - 1);
+            slots[s] = slot;
+        }
+    }
+};
+
+// Hash rodante (Rabin-Karp) de los shingles: h(s) = s[0] B^(k-1) + ... + s[k-1] módulo 2^64, de modo
+// que el hash de la posición siguiente se obtiene en O(1) sin volver a leer los k símbolos. El valor
+// se pasa por mixHash para que los bits bajos y altos sean uniformes, como necesita MinHash
+const uint64_t rollingBase = 0x9e3779b97f4a7c15ULL; // Base impar del polinomio
+
+// Función para calcular B^k módulo 2^64, el peso con el que sale el símbolo más antiguo
+inline uint64_t rollingPower(int k) {
+    uint64_t power = 1;
+    for (int i = 0; i < k; ++i) power *= rollingBase;
+    return power;
+}
+
+// Símbolo como entero sin signo: bytes, identificadores de token o hashes de palabra
+template <typename Symbol>
+inline uint64_t rollingSymbol(Symbol symbol) {
+    return static_cast<uint64_t>(static_cast<make_unsigned_t<Symbol>>(symbol));
+}
+
+// Función para encontrar todas las subcadenas comunes de al menos `minLength` entre dos cadenas.
+// `CharT` es char para el texto original o char32_t para las secuencias de tokens. Las subcadenas
+// se deduplican por su huella polinómica (O(1) a partir de los hashes de los prefijos de str1); con
+// `verify` además se comparan contra el intervalo ya guardado cuando coinciden las huellas
+template <typename CharT>
+vector<basic_string_view<CharT>> findCommonSubstrings(basic_string_view<CharT> str1, basic_string_view<CharT> str2,
+                                                      int minLength, bool verify = false) {
+    ArenaScope scope;                          // La tabla y los conjuntos se liberan al terminar el par
     int m = str1.size();                       // Longitud de la primera cadena
     int n = str2.size();                       // Longitud de la segunda cadena
-    vector<vector<int>> dp(m + 1, vector<int>(n + 1, 0)); // Tabla DP para longitudes de subcadenas comunes
+    countStat(runStats().dpCells, static_cast<uint64_t>(m) * n);
+    // prefix[i] es el hash de str1[0, i) y power[l] = B^l: hash(str1[s, s + l)) = prefix[s + l] - prefix[s] B^l
+    ArenaVector<uint64_t> prefix(m + 1, 0, ArenaAllocator<uint64_t>(scope.get()));
+    ArenaVector<uint64_t> power(m + 1, 1, ArenaAllocator<uint64_t>(scope.get()));
+    for (int i = 0; i < m; ++i) {
+        prefix[i + 1] = prefix[i] * rollingBase + rollingSymbol(str1[i]);
+        power[i + 1] = power[i] * rollingBase;
+    }
+    FingerprintSet fingerprints(64, scope.get());          // Huellas de las subcadenas ya vistas
+    SpanHashSet<CharT> spans(str1, verify ? 64 : 0, scope.get()); // Intervalos de str1 (sólo con verify)
+    vector<basic_string_view<CharT>> result;   // Subcadenas únicas comunes
+    // Cada fila de la tabla DP sólo depende de la anterior: bastan dos filas de longitudes
+    ArenaVector<int> prev(n + 1, 0, ArenaAllocator<int>(scope.get()));
+    ArenaVector<int> cur(n + 1, 0, ArenaAllocator<int>(scope.get()));
 
     // Llenamos la tabla DP para encontrar todas las subcadenas comunes
     for (int i = 1; i <= m; ++i) {
         for (int j = 1; j <= n; ++j) {
             if (str1[i - 1] == str2[j - 1]) {      // Comprobamos si los caracteres coinciden
-                dp[i][j] = dp[i - 1][j - 1] + 1;   // Extendemos la longitud de la subcadena en la tabla DP
-                if (dp[i][j] >= minLength) {       // Si la longitud es mayor o igual a minLength
-                    substrings.insert(str1.substr(i - dp[i][j], dp[i][j])); // Insertamos la subcadena común
+                cur[j] = prev[j - 1] + 1;          // Extendemos la longitud de la subcadena en la tabla DP
+                if (cur[j] >= minLength) {         // Si la longitud es mayor o igual a minLength
+                    int start = i - cur[j];
+                    uint64_t hash = mixHash(prefix[i] - prefix[start] * power[cur[j]]);
+                    bool inserted = verify ? spans.insert(hash, start, cur[j]) : fingerprints.insert(hash);
+                    if (inserted) {
+                        result.push_back(str1.substr(start, cur[j])); // Insertamos la subcadena común
+                    }
                 }
+            } else {
+                cur[j] = 0;
             }
         }
+        swap(prev, cur);
     }
-
-    return vector<string>(substrings.begin(), substrings.end()); // Devolvemos el set como un vector
+    return result;
 }
 
-// Función para calcular la métrica de similitud entre dos cadenas basada en subcadenas comunes
-double similarityMetric(const string &str1, const string &str2, int minLength) {
-    // Obtenemos todas las subcadenas comunes de longitud >= minLength
-    vector<string> commonSubstrings = findCommonSubstrings(str1, str2, minLength); 
-    int totalLength = 0;                      // Variable para acumular la longitud total de subcadenas comunes
-    for (const auto &substring : commonSubstrings) {
-        totalLength += substring.size();      // Sumamos la longitud de cada subcadena a totalLength
+// Estructura que representa una coincidencia entre dos cadenas como un intervalo (offset, longitud)
+struct MatchSpan {
+    int pos1;    // Posición inicial de la coincidencia en la primera cadena
+    int pos2;    // Posición inicial de la coincidencia en la segunda cadena
+    int length;  // Longitud de la coincidencia
+};
+
+// Motores disponibles para calcular las subcadenas comunes
+enum class SubstringBackend {
+    DynamicProgramming, // Tabla DP original, O(m * n) en tiempo y memoria
+    SuffixAutomaton     // Autómata de sufijos, O(m + n) en tiempo y memoria
+};
+
+// Autómata de sufijos de una cadena: reconoce todas sus subcadenas con a lo más 2n estados. Los
+// símbolos son bytes (char) o identificadores de token (char32_t). Las transiciones están en listas
+// enlazadas por estado salvo las de la raíz, que tiene casi todo el alfabeto y a la que el recorrido
+// vuelve tras cada discrepancia: con RootTable se guardan además en una tabla directa por símbolo
+// (de 256 entradas con bytes; con tokens crece hasta el mayor identificador del texto)
+template <typename CharT, bool RootTable = true>
+class BasicSuffixAutomaton {
+public:
+    using Symbol = make_unsigned_t<CharT>;   // Símbolo de las transiciones
+
+    struct State {
+        int length;     // Longitud de la subcadena más larga del estado
+        int link;       // Enlace de sufijo (-1 para la raíz)
+        int firstEdge;  // Índice de la primera transición del estado
+        int firstEnd;   // Posición final de la primera aparición de las subcadenas del estado
+    };
+
+    // Construye el autómata de `text`, reutilizando la memoria de construcciones anteriores
+    void build(basic_string_view<CharT> text) {
+        if constexpr (RootTable && byteAlphabet) {
+            rootEdges.assign(256, -1);
+        } else if constexpr (RootTable) {
+            for (int e = states.empty() ? -1 : states[0].firstEdge; e != -1; e = edges[e].next) {
+                rootEdges[edges[e].symbol] = -1; // Sólo las entradas que usó el texto anterior
+            }
+        }
+        states.clear();
+        edges.clear();
+        states.push_back({0, -1, -1, -1}); // Estado raíz (cadena vacía)
+        last = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            extend(static_cast<Symbol>(text[i]), static_cast<int>(i));
+        }
+        sortByLength();
     }
-    int maxLength = max(str1.size(), str2.size()); // Obtenemos la longitud de la cadena más larga entre ambas
-    return static_cast<double>(totalLength) / maxLength; // Calculamos la proporción de similitud
-}
 
-// Función para calcular la distancia de edición (Levenshtein)
-int editDistance(const string &str1, const string &str2) {
-    int m = str1.size();
-    int n = str2.size();
-    vector<vector<int>> dp(m + 1, vector<int>(n + 1, 0));
-
-    for (int i = 0; i <= m; ++i) {
-        for (int j = 0; j <= n; ++j) {
-            if (i == 0) {
-                dp[i][j] = j; // Si str1 está vacío, insertamos todos los caracteres de str2
-            } else if (j == 0) {
-                dp[i][j] = i; // Si str2 está vacío, eliminamos todos los caracteres de str1
-            } else if (str1[i - 1] == str2[j - 1]) {
-                dp[i][j] = dp[i - 1][j - 1]; // Sin costo si son iguales
+    // Devuelve el estado destino de la transición con `symbol`, o -1 si no existe
+    int transition(int state, Symbol symbol) const {
+        if constexpr (RootTable) {
+            if (state == 0) {
+                if constexpr (byteAlphabet) {
+                    return rootEdges[symbol];
+                } else {
+                    return symbol < rootEdges.size() ? rootEdges[symbol] : -1;
+                }
+            }
+        }
+        for (int e = states[state].firstEdge; e != -1; e = edges[e].next) {
+            if (edges[e].symbol == symbol) {
+                return edges[e].target;
+            }
+        }
+        return -1;
+    }
+
+    const vector<State> &getStates() const { return states; }
+
+    // Estados ordenados por longitud creciente (se calcula al construir el autómata)
+    const vector<int> &getLengthOrder() const { return lengthOrder; }
+
+    // Recorre `text` sobre el autómata y llama visit(i, estado, longitud) con la coincidencia
+    // más larga que termina en la posición i (estadísticas de coincidencia)
+    template <typename Visitor>
+    void matchingStatistics(basic_string_view<CharT> text, Visitor visit) const {
+        int state = 0;   // Estado actual del recorrido
+        int length = 0;  // Longitud de la coincidencia actual
+        for (size_t i = 0; i < text.size(); ++i) {
+            Symbol symbol = static_cast<Symbol>(text[i]);
+            int next = transition(state, symbol);
+            while (next == -1 && state != 0) {     // Acortamos la coincidencia por los enlaces de sufijo
+                state = states[state].link;
+                length = states[state].length;
+                next = transition(state, symbol);
+            }
+            if (next == -1) {                      // Ni siquiera el carácter aparece en el texto
+                state = 0;
+                length = 0;
             } else {
-                dp[i][j] = 1 + min({dp[i - 1][j], dp[i][j - 1], dp[i - 1][j - 1]}); // Inserción, eliminación o sustitución
+                state = next;
+                length++;
             }
+            visit(static_cast<int>(i), state, length);
         }
     }
 
-    return dp[m][n]; // Devolvemos la distancia de edición
-}
+private:
+    struct Edge {
+        int target;            // Estado destino
+        int next;              // Siguiente arista del mismo estado
+        Symbol symbol;         // Símbolo de la transición
+    };
 
-// Función para calcular la métrica de contención de Broder
-double broderContainment(const string &str1, const string &str2) {
-    unordered_set<string> substrings1;
-    unordered_set<string> substrings2;
+    // Con bytes la tabla de la raíz tiene siempre 256 entradas y no hay que comprobar el símbolo
+    static constexpr bool byteAlphabet = sizeof(Symbol) == 1;
 
-    // Generamos subcadenas de str1
-    for (size_t i = 0; i < str1.size(); ++i) {
-        for (size_t j = i + 1; j <= str1.size(); ++j) {
-            substrings1.insert(str1.substr(i, j - i));
+    vector<State> states;     // Estados del autómata
+    vector<Edge> edges;       // Aristas de todos los estados en listas enlazadas
+    vector<int> lengthOrder;  // Estados ordenados por longitud (counting sort)
+    vector<int> bucket;       // Contadores del counting sort
+    vector<int> rootEdges;    // Transiciones de la raíz indexadas por símbolo (-1 si no hay)
+    int last = 0;             // Estado que representa el texto completo leído hasta ahora
+
+    // Ordena los estados por longitud para poder propagar información por los enlaces de sufijo
+    void sortByLength() {
+        int maxLength = states[last].length;  // El último estado representa el texto completo
+        bucket.assign(maxLength + 2, 0);
+        lengthOrder.resize(states.size());
+        for (const auto &s : states) bucket[s.length + 1]++;
+        for (int l = 1; l <= maxLength + 1; ++l) bucket[l] += bucket[l - 1];
+        for (int v = 0; v < static_cast<int>(states.size()); ++v) lengthOrder[bucket[states[v].length]++] = v;
+    }
+
+    void addEdge(int from, Symbol symbol, int to) {
+        if constexpr (RootTable) {
+            if (from == 0) {
+                if constexpr (!byteAlphabet) {
+                    if (symbol >= rootEdges.size()) rootEdges.resize(static_cast<size_t>(symbol) + 1, -1);
+                }
+                rootEdges[symbol] = to;
+            }
         }
+        edges.push_back({to, states[from].firstEdge, symbol});
+        states[from].firstEdge = static_cast<int>(edges.size()) - 1;
     }
 
-    // Generamos subcadenas de str2
-    for (size_t i = 0; i < str2.size(); ++i) {
-        for (size_t j = i + 1; j <= str2.size(); ++j) {
-            substrings2.insert(str2.substr(i, j - i));
+    void redirectEdge(int from, Symbol symbol, int to) {
+        if constexpr (RootTable) {
+            if (from == 0) rootEdges[symbol] = to;
+        }
+        for (int e = states[from].firstEdge; e != -1; e = edges[e].next) {
+            if (edges[e].symbol == symbol) {
+                edges[e].target = to;
+                return;
+            }
         }
     }
 
-    // Contamos las subcadenas de str1 que están en str2
-    int countContained = 0;
-    for (const auto &s : substrings1) {
-        if (substrings2.count(s)) {
-            countContained++;
+    // Agrega un carácter al final del texto reconocido (construcción en línea de Blumer et al.)
+    void extend(Symbol symbol, int position) {
+        int cur = static_cast<int>(states.size());
+        states.push_back({states[last].length + 1, 0, -1, position});
+        int p = last;
+        while (p != -1 && transition(p, symbol) == -1) {
+            addEdge(p, symbol, cur);
+            p = states[p].link;
+        }
+        if (p != -1) {
+            int q = transition(p, symbol);
+            if (states[p].length + 1 == states[q].length) {
+                states[cur].link = q;
+            } else {
+                int clone = static_cast<int>(states.size()); // Clonamos q para separar sus subcadenas cortas
+                states.push_back({states[p].length + 1, states[q].link, -1, states[q].firstEnd});
+                for (int e = states[q].firstEdge; e != -1; e = edges[e].next) {
+                    Edge copy = edges[e];                     // Copiamos antes de que push_back invalide referencias
+                    addEdge(clone, copy.symbol, copy.target);
+                }
+                while (p != -1 && transition(p, symbol) == q) {
+                    redirectEdge(p, symbol, clone);
+                    p = states[p].link;
+                }
+                states[q].link = clone;
+                states[cur].link = clone;
+            }
         }
+        last = cur;
     }
+};
+
+using SuffixAutomaton = BasicSuffixAutomaton<char>;     // Autómata sobre los bytes del texto
+using TokenAutomaton = BasicSuffixAutomaton<char32_t>;  // Autómata sobre identificadores de token
 
-    return static_cast<double>(countContained) / substrings1.size(); // Proporción de subcadenas contenidas
+// Función para encontrar las coincidencias maximales de al menos `minLength` entre `str1` y `str2`,
+// dado el autómata de sufijos de `str2`. Cada coincidencia se reporta una vez, en el punto donde
+// ya no puede extenderse a la derecha, con la posición de su primera aparición en `str2`
+template <typename CharT>
+vector<MatchSpan> findMaximalMatches(basic_string_view<CharT> str1, const BasicSuffixAutomaton<CharT> &automaton2,
+                                     int minLength) {
+    vector<MatchSpan> matches;
+    const auto &states = automaton2.getStates();
+    int prevLength = 0;  // Longitud de la coincidencia que termina en la posición anterior
+    int prevState = 0;   // Estado del autómata en la posición anterior
+    int prevEnd = -1;    // Posición anterior
+    auto emit = [&](int end, int state, int length) {
+        if (length >= minLength) {
+            matches.push_back({end - length + 1, states[state].firstEnd - length + 1, length});
+        }
+    };
+    automaton2.matchingStatistics(str1, [&](int i, int state, int length) {
+        if (prevEnd >= 0 && length != prevLength + 1) { // La coincidencia anterior no se extendió
+            emit(prevEnd, prevState, prevLength);
+        }
+        prevLength = length;
+        prevState = state;
+        prevEnd = i;
+    });
+    if (prevEnd >= 0) {
+        emit(prevEnd, prevState, prevLength);
+    }
+    return matches;
 }
 
-// Función para generar una matriz de similitud para un vector de documentos
-vector<vector<double>> generateSimilarityMatrix(const vector<string> &documents, int minLength) {
-    int n = documents.size();                 // Número de documentos
-    vector<vector<double>> similarityMatrix(n, vector<double>(n, 0.0)); // Matriz n x n inicializada en 0.0
+// Función de conveniencia que construye el autómata de `str2` y devuelve las coincidencias maximales
+template <typename CharT>
+vector<MatchSpan> findMaximalMatches(basic_string_view<CharT> str1, basic_string_view<CharT> str2, int minLength) {
+    BasicSuffixAutomaton<CharT> automaton2;
+    automaton2.build(str2);
+    return findMaximalMatches(str1, automaton2, minLength);
+}
 
-    // Calculamos la similitud para cada par de documentos
-    for (int i = 0; i < n; ++i) {
-        for (int j = i + 1; j < n; ++j) {
-            double similarity = similarityMetric(documents[i], documents[j], minLength); // Calculamos similitud
-            similarityMatrix[i][j] = similarity;      // Asignamos el valor de similitud en la matriz
-            similarityMatrix[j][i] = similarity;      // Reflejamos el valor para hacer simétrica la matriz
+// Función para calcular, sin enumerar cadenas, la suma de longitudes del conjunto que devuelve
+// findCommonSubstrings. Para cada par de posiciones (i, j) la DP inserta el sufijo común más largo;
+// en el autómata de `str2` eso corresponde a la coincidencia actual en i y al texto más largo de
+// cada ancestro por enlaces de sufijo. Complejidad O((m + n) log m)
+// Memoria temporal de commonSubstringMass, reutilizable entre pares del mismo hilo
+struct MassScratch {
+    vector<char> visited;    // Estados alcanzados al final de alguna posición de str1
+    vector<char> ancestor;   // Estados que son ancestro de algún estado visitado
+    vector<uint64_t> keys;   // Pares (estado, longitud) que representan cada subcadena
+};
+
+template <typename CharT>
+long long commonSubstringMass(basic_string_view<CharT> str1, const BasicSuffixAutomaton<CharT> &automaton2,
+                              int minLength, MassScratch &scratch) {
+    const auto &states = automaton2.getStates();
+    int stateCount = states.size();
+    vector<char> &visited = scratch.visited;
+    vector<uint64_t> &keys = scratch.keys;
+    visited.assign(stateCount, 0);
+    keys.clear();
+    automaton2.matchingStatistics(str1, [&](int, int state, int length) {
+        visited[state] = 1;
+        if (length >= minLength) {
+            keys.push_back((static_cast<uint64_t>(state) << 32) | static_cast<uint32_t>(length));
+        }
+    });
+
+    // Recorremos los estados por longitud decreciente para propagar hacia la raíz:
+    // un ancestro de un estado visitado aporta su subcadena más larga
+    const vector<int> &order = automaton2.getLengthOrder();
+    vector<char> &ancestor = scratch.ancestor;
+    ancestor.assign(stateCount, 0);
+    for (int k = stateCount - 1; k > 0; --k) {
+        int v = order[k];
+        if (visited[v] || ancestor[v]) {
+            ancestor[states[v].link] = 1;
+        }
+    }
+    for (int v = 1; v < stateCount; ++v) {
+        if (ancestor[v] && states[v].length >= minLength) {
+            keys.push_back((static_cast<uint64_t>(v) << 32) | static_cast<uint32_t>(states[v].length));
         }
     }
-    return similarityMatrix; // Devolvemos la matriz de similitud
+
+    // Eliminamos duplicados y sumamos las longitudes
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    long long total = 0;
+    for (uint64_t key : keys) {
+        total += static_cast<uint32_t>(key);
+    }
+    return total;
+}
+
+// Versión sin memoria reutilizable, para pares aislados
+template <typename CharT>
+long long commonSubstringMass(basic_string_view<CharT> str1, const BasicSuffixAutomaton<CharT> &automaton2,
+                              int minLength) {
+    MassScratch scratch;
+    return commonSubstringMass(str1, automaton2, minLength, scratch);
 }
 
-// Función para resaltar subcadenas similares entre dos textos en un formato HTML
-string highlightSimilarities(const string &str1, const string &str2, int minLength) {
-    // Obtenemos las subcadenas comunes de longitud >= minLength
-    vector<string> commonSubstrings = findCommonSubstrings(str1, str2, minLength); 
-    string highlightedStr1 = str1;         // Copia de la primera cadena para resaltar
-    string highlightedStr2 = str2;         // Copia de la segunda cadena para resaltar
+// Medidas de similitud disponibles
+enum class SimilarityMode {
+    Mass,     // Suma de las longitudes de las subcadenas comunes distintas / longitud mayor (puede pasar de 1)
+    Coverage  // Fracción de los caracteres de ambos textos cubiertos por coincidencias >= minLength
+};
+
+// Ventanas de una longitud fija de la fila, identificadas por el estado de su autómata: una subcadena
+// de la fila de longitud `length` es la ventana del único estado v con link(v).length < length <=
+// v.length en la cadena de enlaces de sus apariciones, así que cada ventana distinta es un estado
+struct WindowMarks {
+    int length = 0;             // Longitud de las ventanas
+    int distinct = 0;           // Ventanas distintas de la fila
+    vector<int> ancestor;       // Estado de la ventana que es sufijo de cada estado (-1 si es más corto)
+    vector<char> hit;           // Ventanas de la fila (por estado) que aparecen en el otro texto
+    vector<int> touched;        // Estados marcados en `hit`, para limpiarlos después del par
+
+    // Función para asociar cada estado del autómata de la fila al de su sufijo de longitud `windowLength`
+    template <typename CharT>
+    void prepare(const BasicSuffixAutomaton<CharT> &automaton, int windowLength) {
+        const auto &states = automaton.getStates();
+        length = windowLength;
+        distinct = 0;
+        ancestor.assign(states.size(), -1);
+        for (int v : automaton.getLengthOrder()) { // El enlace de sufijo se procesa antes que el estado
+            if (v == 0 || states[v].length < length) continue;
+            int link = states[v].link;
+            if (states[link].length < length) {
+                ancestor[v] = v;
+                distinct++;
+            } else {
+                ancestor[v] = ancestor[link];
+            }
+        }
+        hit.assign(states.size(), 0);
+        touched.clear();
+    }
+
+    // Función para marcar la ventana que termina en un estado con coincidencia de al menos `length`
+    void mark(int state) {
+        int window = ancestor[state];
+        if (!hit[window]) {
+            hit[window] = 1;
+            touched.push_back(window);
+        }
+    }
+
+    // Función para desmarcar las ventanas del par anterior
+    void clear() {
+        for (int window : touched) {
+            hit[window] = 0;
+        }
+        touched.clear();
+    }
+};
+
+// Memoria de la similitud por cobertura ligada al autómata de la fila actual
+struct CoverageScratch {
+    WindowMarks windows;        // Ventanas de longitud minLength
+    vector<int> windowState;    // Estado de la ventana de longitud minLength que termina en cada posición de la fila
+    WindowMarks shingles;       // k-shingles de la fila para la contención (sin preparar: length == 0)
+};
 
-    // Insertamos las etiquetas <mark> alrededor de cada subcadena común en ambas cadenas
-    for (const auto &substring : commonSubstrings) {
-        size_t pos1 = highlightedStr1.find(substring); // Encontramos la posición en la primera cadena
-        size_t pos2 = highlightedStr2.find(substring); // Encontramos la posición en la segunda cadena
-        if (pos1 != string::npos) {                     // Si se encuentra la subcadena en la primera cadena
-            highlightedStr1.insert(pos1, "<mark>");     // Insertamos la etiqueta de apertura
-            highlightedStr1.insert(pos1 + substring.size() + 6, "</mark>"); // Etiqueta de cierre
+// Función para preparar la cobertura de la fila `row` a partir de su autómata: cada estado se asocia al
+// estado de su sufijo de longitud minLength y cada posición de la fila al de la ventana que termina en
+// ella. O(|row|), una vez por fila
+template <typename CharT>
+void prepareCoverage(basic_string_view<CharT> row, const BasicSuffixAutomaton<CharT> &automaton, int minLength,
+                     CoverageScratch &scratch) {
+    scratch.windows.prepare(automaton, minLength);
+    scratch.windowState.assign(row.size(), -1);
+    automaton.matchingStatistics(row, [&](int e, int state, int length) {
+        if (length >= minLength) scratch.windowState[e] = scratch.windows.ancestor[state];
+    });
+    scratch.shingles.length = 0;
+}
+
+// Función para calcular la similitud por cobertura: (cubiertos de `row` + cubiertos de `other`) /
+// (|row| + |other|), entre 0 y 1. Un carácter está cubierto si pertenece a una subcadena común de
+// longitud >= minLength. Se recorre `other` una vez sobre el autómata de `row` (ya preparado con
+// prepareCoverage), sin construir el autómata de `other`:
+// - la coincidencia más larga que termina en cada posición de `other` contiene a las demás que terminan
+//   ahí y su inicio nunca retrocede, así que la unión de sus intervalos se acumula en la misma pasada;
+// - su sufijo de longitud minLength es una ventana común y se marca su estado; las posiciones de `row`
+//   cubiertas son la unión de sus ventanas marcadas, porque toda subcadena común larga se compone de
+//   ventanas comunes. O(|row| + |other|)
+// Si además se prepararon los k-shingles de la fila y se pasa `containment`, el mismo recorrido da la
+// contención exacta de shingleContainment(row, other, k): un k-shingle de `row` aparece en `other`
+// justo cuando alguna posición de `other` tiene una coincidencia de longitud >= k que lo termina
+template <typename CharT>
+double coverageSimilarity(basic_string_view<CharT> row, basic_string_view<CharT> other,
+                          const BasicSuffixAutomaton<CharT> &rowAutomaton, int minLength, CoverageScratch &scratch,
+                          double *containment = nullptr) {
+    WindowMarks *shingles = containment != nullptr && scratch.shingles.length > 0 ? &scratch.shingles : nullptr;
+    long long covered = 0;
+    int coveredEnd = 0;                        // Fin (exclusivo) de la parte ya contada
+    rowAutomaton.matchingStatistics(other, [&](int i, int state, int length) {
+        if (length >= minLength) {
+            covered += i + 1 - max(i + 1 - length, coveredEnd);
+            coveredEnd = i + 1;
+            scratch.windows.mark(state);
+        }
+        if (shingles != nullptr && length >= shingles->length) {
+            shingles->mark(state);
         }
-        if (pos2 != string::npos) {                     // Si se encuentra la subcadena en la segunda cadena
-            highlightedStr2.insert(pos2, "<mark>");     // Insertamos la etiqueta de apertura
-            highlightedStr2.insert(pos2 + substring.size() + 6, "</mark>"); // Etiqueta de cierre
+    });
+    if (shingles != nullptr) {
+        *containment = shingles->distinct > 0 ? static_cast<double>(shingles->touched.size()) / shingles->distinct : 0.0;
+        shingles->clear();
+    }
+    if (covered == 0) {
+        return 0.0;                            // Sin coincidencias en `other` tampoco las hay en `row`
+    }
+    coveredEnd = 0;
+    for (int e = minLength - 1; e < static_cast<int>(row.size()); ++e) {
+        if (scratch.windows.hit[scratch.windowState[e]]) {
+            covered += e + 1 - max(e + 1 - minLength, coveredEnd);
+            coveredEnd = e + 1;
         }
     }
+    scratch.windows.clear();
+    return static_cast<double>(covered) / (row.size() + other.size());
+}
 
-    // Devolvemos el resultado formateado en HTML
-    return "<h3>Texto 1:</h3><p>" + highlightedStr1 + "</p><h3>Texto 2:</h3><p>" + highlightedStr2 + "</p>";
+// Función para calcular con la tabla DP de sufijos comunes las estadísticas de coincidencia de cada
+// texto contra el otro: `longest1[i]` (y `longest2[j]`) es la longitud máxima de la fila i (columna j),
+// la coincidencia más larga que termina en esa posición. Ambos vectores deben venir con m y n ceros.
+// O(m * n) en tiempo y O(n) de memoria temporal
+template <typename CharT, typename Lengths>
+void dynamicMatchingStatistics(basic_string_view<CharT> str1, basic_string_view<CharT> str2, Lengths &longest1,
+                               Lengths &longest2) {
+    int m = str1.size();
+    int n = str2.size();
+    countStat(runStats().dpCells, static_cast<uint64_t>(m) * n);
+    ArenaScope scope;
+    ArenaVector<int> prev(n + 1, 0, ArenaAllocator<int>(scope.get()));
+    ArenaVector<int> cur(n + 1, 0, ArenaAllocator<int>(scope.get()));
+    for (int i = 1; i <= m; ++i) {
+        for (int j = 1; j <= n; ++j) {
+            cur[j] = str1[i - 1] == str2[j - 1] ? prev[j - 1] + 1 : 0;
+            longest1[i - 1] = max(longest1[i - 1], cur[j]);
+            longest2[j - 1] = max(longest2[j - 1], cur[j]);
+        }
+        swap(prev, cur);
+    }
 }
 
-// Función para comparar pares de documentos basado en la matriz de similitud
-bool comparePairs(const pair<int, int> &a, const pair<int, int> &b, const vector<vector<double>> &similarityMatrix) {
-    // Retorna true si la similitud del par `a` es mayor que la del par `b`
-    return similarityMatrix[a.first][a.second] > similarityMatrix[b.first][b.second]; 
+// Función para calcular la cobertura con la tabla DP (referencia de --backend dp): las estadísticas de
+// coincidencia de dynamicMatchingStatistics se acumulan como en coverageSimilarity. O(m * n)
+template <typename CharT>
+double dynamicCoverageSimilarity(basic_string_view<CharT> str1, basic_string_view<CharT> str2, int minLength) {
+    int m = str1.size();
+    int n = str2.size();
+    if (m + n == 0) {
+        return 0.0;
+    }
+    ArenaScope scope;
+    ArenaVector<int> longest1(m, 0, ArenaAllocator<int>(scope.get())); // Coincidencia más larga que termina en i
+    ArenaVector<int> longest2(n, 0, ArenaAllocator<int>(scope.get())); // Ídem para cada posición de str2
+    dynamicMatchingStatistics(str1, str2, longest1, longest2);
+    long long covered = 0;
+    for (const auto *longest : {&longest1, &longest2}) {
+        int coveredEnd = 0;
+        for (int i = 0; i < static_cast<int>(longest->size()); ++i) {
+            int length = (*longest)[i];
+            if (length >= minLength) {
+                covered += i + 1 - max(i + 1 - length, coveredEnd);
+                coveredEnd = i + 1;
+            }
+        }
+    }
+    return static_cast<double>(covered) / (m + n);
 }
 
-// Función principal
-int main() {
-    // Vector para almacenar el contenido de todos los documentos de la carpeta "dataset"
-    vector<string> documents;
-    for (const auto &entry : fs::directory_iterator("dataset")) { // Iteramos cada archivo en la carpeta "dataset"
-        documents.push_back(readFile(entry.path().string()));    // Leemos y añadimos el contenido al vector documents
+// Función para calcular la métrica de similitud entre dos cadenas basada en subcadenas comunes
+template <typename CharT>
+double similarityMetric(basic_string_view<CharT> str1, basic_string_view<CharT> str2, int minLength,
+                        SubstringBackend backend = SubstringBackend::SuffixAutomaton, bool verifySpans = false,
+                        SimilarityMode mode = SimilarityMode::Mass) {
+    if (mode == SimilarityMode::Coverage) {
+        if (backend == SubstringBackend::DynamicProgramming) {
+            return dynamicCoverageSimilarity(str1, str2, minLength);
+        }
+        BasicSuffixAutomaton<CharT> automaton1;
+        CoverageScratch coverage;
+        automaton1.build(str1);
+        prepareCoverage(str1, automaton1, minLength, coverage);
+        return coverageSimilarity(str1, str2, automaton1, minLength, coverage);
+    }
+    long long totalLength = 0;                // Variable para acumular la longitud total de subcadenas comunes
+    if (backend == SubstringBackend::SuffixAutomaton) {
+        BasicSuffixAutomaton<CharT> automaton2; // Autómata de la segunda cadena
+        automaton2.build(str2);
+        totalLength = commonSubstringMass(str1, automaton2, minLength); // Misma suma sin construir las cadenas
+    } else {
+        // Obtenemos todas las subcadenas comunes de longitud >= minLength
+        vector<basic_string_view<CharT>> commonSubstrings = findCommonSubstrings(str1, str2, minLength, verifySpans);
+        for (const auto &substring : commonSubstrings) {
+            totalLength += substring.size();  // Sumamos la longitud de cada subcadena a totalLength
+        }
     }
+    int maxLength = max(str1.size(), str2.size()); // Obtenemos la longitud de la cadena más larga entre ambas
+    return static_cast<double>(totalLength) / maxLength; // Calculamos la proporción de similitud
+}
 
-    // Definimos la longitud mínima de subcadenas comunes para la comparación
-    int minLength = 5;
+// Función para calcular la distancia de edición (Levenshtein) con memoria lineal:
+// sólo se conservan la fila anterior y la fila actual de la tabla DP
+template <typename CharT>
+int editDistance(basic_string_view<CharT> str1, basic_string_view<CharT> str2) {
+    basic_string_view<CharT> rows = str1.size() >= str2.size() ? str1 : str2; // Cadena que recorre las filas
+    basic_string_view<CharT> cols = str1.size() >= str2.size() ? str2 : str1; // La más corta define el ancho de fila
+    int m = rows.size();
+    int n = cols.size();
+    countStat(runStats().dpCells, static_cast<uint64_t>(m) * n);
+    ArenaScope scope;                          // Las dos filas se toman de la arena del hilo
+    ArenaVector<int> prev(n + 1, 0, ArenaAllocator<int>(scope.get()));
+    ArenaVector<int> cur(n + 1, 0, ArenaAllocator<int>(scope.get()));
+
+    for (int j = 0; j <= n; ++j) {
+        prev[j] = j; // Si la primera cadena está vacía, insertamos todos los caracteres de la segunda
+    }
+    for (int i = 1; i <= m; ++i) {
+        cur[0] = i; // Si la segunda cadena está vacía, eliminamos todos los caracteres de la primera
+        for (int j = 1; j <= n; ++j) {
+            if (rows[i - 1] == cols[j - 1]) {
+                cur[j] = prev[j - 1]; // Sin costo si son iguales
+            } else {
+                cur[j] = 1 + min({prev[j], cur[j - 1], prev[j - 1]}); // Inserción, eliminación o sustitución
+            }
+        }
+        swap(prev, cur);
+    }
 
-    // Generamos la matriz de similitud para todos los pares de documentos
-    vector<vector<double>> similarityMatrix = generateSimilarityMatrix(documents, minLength);
+    return prev[n]; // Devolvemos la distancia de edición
+}
 
-    // Vector para almacenar todos los pares posibles de documentos
-    vector<pair<int, int>> mostSimilarPairs;
-    for (int i = 0; i < documents.size(); ++i) {
-        for (int j = i + 1; j < documents.size(); ++j) {
-            mostSimilarPairs.push_back({i, j});  // Añadimos cada par único (i, j) al vector
+// Función para calcular la distancia de edición acotada por `maxDistance` (banda de Ukkonen).
+// Sólo se evalúan las celdas con |i - j| <= maxDistance y el cálculo termina en cuanto toda la
+// banda supera el umbral. Devuelve la distancia exacta si es <= maxDistance, o maxDistance + 1
+// en caso contrario. Complejidad O(maxDistance * min(a, b)) en tiempo y O(b) en memoria
+template <typename CharT>
+int boundedEditDistance(basic_string_view<CharT> str1, basic_string_view<CharT> str2, int maxDistance) {
+    basic_string_view<CharT> rows = str1.size() >= str2.size() ? str1 : str2;
+    basic_string_view<CharT> cols = str1.size() >= str2.size() ? str2 : str1;
+    int m = rows.size();
+    int n = cols.size();
+    const int limit = maxDistance + 1;          // Valor que representa "fuera del umbral"
+    if (maxDistance < 0 || m - n > maxDistance) {
+        return limit;                           // La diferencia de longitudes ya excede el umbral
+    }
+    ArenaScope scope;
+    ArenaVector<int> prev(n + 1, limit, ArenaAllocator<int>(scope.get()));
+    ArenaVector<int> cur(n + 1, limit, ArenaAllocator<int>(scope.get()));
+    for (int j = 0; j <= min(n, maxDistance); ++j) {
+        prev[j] = j;
+    }
+    uint64_t cells = 0;                         // Celdas de la banda evaluadas
+    for (int i = 1; i <= m; ++i) {
+        int lo = max(1, i - maxDistance);       // Primera columna de la banda
+        int hi = min(n, i + maxDistance);       // Última columna de la banda
+        cells += max(0, hi - lo + 1);
+        cur[lo - 1] = (lo == 1 && i <= maxDistance) ? i : limit; // Borde izquierdo de la banda
+        int rowMin = cur[lo - 1];
+        for (int j = lo; j <= hi; ++j) {
+            int value;
+            if (rows[i - 1] == cols[j - 1]) {
+                value = prev[j - 1];
+            } else {
+                value = 1 + min({prev[j], cur[j - 1], prev[j - 1]});
+            }
+            cur[j] = min(value, limit);         // Los valores fuera del umbral se saturan
+            rowMin = min(rowMin, cur[j]);
+        }
+        if (hi < n) {
+            cur[hi + 1] = limit;                // Celda siguiente a la banda, leída en la próxima fila
         }
+        if (rowMin >= limit) {
+            countStat(runStats().dpCells, cells);
+            return limit;                       // Ninguna celda de la banda cumple el umbral
+        }
+        swap(prev, cur);
     }
+    countStat(runStats().dpCells, cells);
+    return prev[n];
+}
 
-    // Ordenamos los pares de documentos por similitud en orden descendente
-    sort(mostSimilarPairs.begin(), mostSimilarPairs.end(), [&](const pair<int, int> &a, const pair<int, int> &b) {
-        return comparePairs(a, b, similarityMatrix); // Utilizamos lambda para pasar la matriz de similitud por referencia
-    });
+// Implementaciones disponibles de la distancia de edición
+enum class EditKernel {
+    DynamicProgramming, // Tabla DP de dos filas
+    BitParallel         // Myers/Hyyrö, 64 celdas por palabra
+};
+
+// Variantes del núcleo bit-paralelo según el conjunto de instrucciones
+enum class MyersVariant {
+    Scalar,  // Un bloque de 64 filas por operación
+    Avx2,    // 4 bloques en paralelo sobre un frente diagonal
+    Avx512   // 8 bloques en paralelo sobre un frente diagonal
+};
 
-    // Creamos un archivo HTML para mostrar los pares de documentos más similares
-    ofstream htmlFile("similar_texts.html");   // Creamos el archivo HTML de salida
-    htmlFile << "<html><head><title>Textos Más Similares</title></head><body>"; // Encabezado HTML
-    htmlFile << "<h1>10 Pares de Textos Más Similares</h1>";                   // Título del reporte de similitud
+// Tabla de coincidencias del patrón de Myers: para cada símbolo, un bit por fila en bloques de 64
+struct MyersPattern {
+    int length = 0;          // Número de filas (longitud del patrón)
+    int blocks = 0;          // Número de palabras de 64 bits por columna
+    ArenaVector<uint64_t> peq; // peq[símbolo * blocks + bloque], en la arena del hilo
 
-    // Añadimos los 10 pares de documentos más similares al archivo HTML
-    for (int k = 0; k < 10 && k < mostSimilarPairs.size(); ++k) {
-        int i = mostSimilarPairs[k].first;     // Índice del primer documento en el par
-        int j = mostSimilarPairs[k].second;    // Índice del segundo documento en el par
-        double editDist = editDistance(documents[i], documents[j]); // Calculamos la distancia de edición
-        double broderCont = broderContainment(documents[i], documents[j]); // Calculamos la contención de Broder
+    explicit MyersPattern(string_view pattern) : length(pattern.size()), blocks((pattern.size() + 63) / 64) {
+        peq.assign(256 * static_cast<size_t>(blocks), 0);
+        for (int i = 0; i < length; ++i) {
+            unsigned char symbol = static_cast<unsigned char>(pattern[i]);
+            peq[symbol * static_cast<size_t>(blocks) + i / 64] |= 1ULL << (i % 64);
+        }
+    }
+};
+
+// Avanza una columna de un bloque de 64 filas (Hyyrö 2003). `hin` es la diferencia horizontal
+// que entra por la fila superior del bloque (-1, 0 o +1); devuelve la que sale por la inferior.
+// `ph` y `mh` reciben los vectores horizontales antes del corrimiento, para leer cualquier fila
+inline int advanceMyersBlock(uint64_t &pv, uint64_t &mv, uint64_t eq, int hin, uint64_t &ph, uint64_t &mh) {
+    uint64_t hinNeg = hin < 0 ? 1 : 0;
+    uint64_t xv = eq | mv;
+    eq |= hinNeg;
+    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    ph = mv | ~(xh | pv);
+    mh = pv & xh;
+    int hout = static_cast<int>(ph >> 63) - static_cast<int>(mh >> 63);
+    uint64_t phShift = (ph << 1) | (hin > 0 ? 1 : 0);
+    uint64_t mhShift = (mh << 1) | hinNeg;
+    pv = mhShift | ~(xv | phShift);
+    mv = phShift & xv;
+    return hout;
+}
 
-        htmlFile << "<h2>Par " << k + 1 << " (Similitud: " << fixed << setprecision(2) << similarityMatrix[i][j]
-                  << ", Distancia de Edición: " << editDist 
-                  << ", Contención de Broder: " << fixed << setprecision(2) << broderCont << ")</h2>";
-        htmlFile << highlightSimilarities(documents[i], documents[j], minLength); // Resaltamos las secciones comunes
+// Núcleo bit-paralelo escalar: procesa los bloques de cada columna de arriba hacia abajo
+int myersEditDistanceScalar(const MyersPattern &pattern, string_view text) {
+    int w = pattern.blocks;
+    ArenaScope scope;
+    ArenaVector<uint64_t> pv(w, ~0ULL), mv(w, 0); // Diferencias verticales: al inicio D[i][0] = i
+    int score = pattern.length;                // D[m][0]
+    int lastBit = (pattern.length - 1) % 64;   // Fila m dentro del último bloque
+    for (unsigned char symbol : text) {
+        const uint64_t *eq = &pattern.peq[symbol * static_cast<size_t>(w)];
+        int hin = 1;                           // La fila 0 crece en 1 por columna
+        uint64_t ph = 0, mh = 0;
+        for (int b = 0; b < w; ++b) {
+            hin = advanceMyersBlock(pv[b], mv[b], eq[b], hin, ph, mh);
+        }
+        score += static_cast<int>((ph >> lastBit) & 1) - static_cast<int>((mh >> lastBit) & 1);
     }
+    return score;
+}
+
+#ifdef HAVE_X86_SIMD
+// Núcleo AVX2: cada carril de 64 bits es un bloque. Los bloques de un grupo se recorren sobre un
+// frente diagonal (el carril l procesa la columna t - l en el paso t), así el acarreo horizontal
+// que sale del carril l - 1 en un paso es justo el que entra al carril l en el siguiente.
+// Entre grupos de 4 bloques el acarreo se guarda por columna
+__attribute__((target("avx2"))) int myersEditDistanceAvx2(const MyersPattern &pattern, string_view text) {
+    const int lanes = 4;
+    int w = pattern.blocks;
+    int n = text.size();
+    int groups = (w + lanes - 1) / lanes;
+    int lastBlock = w - 1;
+    __m128i lastBit = _mm_cvtsi32_si128((pattern.length - 1) % 64);
+    ArenaScope scope;
+    ArenaVector<signed char> carryIn(n, 1), carryOut(n, 0); // Acarreo horizontal entre grupos por columna
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i laneIndex = _mm256_set_epi64x(3, 2, 1, 0);
+    const __m256i columns = _mm256_set1_epi64x(n);
+    long long delta[lanes];                    // Cambios acumulados de la fila m por carril
+
+    for (int g = 0; g < groups; ++g) {
+        __m256i pv = ones, mv = _mm256_setzero_si256();
+        __m256i houtPos = _mm256_setzero_si256(), houtNeg = _mm256_setzero_si256();
+        __m256i scoreDelta = _mm256_setzero_si256();
+        for (int t = 0; t < n + lanes - 1; ++t) {
+            // Acarreo de entrada: el carril 0 lo toma del grupo anterior, el resto del carril vecino
+            long long inPos = t < n && carryIn[t] > 0, inNeg = t < n && carryIn[t] < 0;
+            __m256i hinPos = _mm256_blend_epi32(_mm256_permute4x64_epi64(houtPos, _MM_SHUFFLE(2, 1, 0, 0)),
+                                                _mm256_set_epi64x(0, 0, 0, inPos), 0x03);
+            __m256i hinNeg = _mm256_blend_epi32(_mm256_permute4x64_epi64(houtNeg, _MM_SHUFFLE(2, 1, 0, 0)),
+                                                _mm256_set_epi64x(0, 0, 0, inNeg), 0x03);
+            bool ramp = t < lanes - 1 || t >= n;   // Entrada o salida del frente: hay carriles inactivos
+            __m256i eq, active = ones;
+            if (!ramp && (g + 1) * lanes <= w) {
+                // En el régimen estable todos los carriles están activos: leemos sin comprobaciones
+                const unsigned char *column = reinterpret_cast<const unsigned char *>(text.data()) + t;
+                const uint64_t *block = pattern.peq.data() + g * lanes;
+                size_t stride = w;
+                eq = _mm256_set_epi64x(block[column[-3] * stride + 3], block[column[-2] * stride + 2],
+                                       block[column[-1] * stride + 1], block[column[0] * stride]);
+            } else {
+                long long eqLane[lanes];
+                for (int l = 0; l < lanes; ++l) {
+                    int j = t - l, b = g * lanes + l;
+                    eqLane[l] = (j >= 0 && j < n && b < w)
+                        ? pattern.peq[static_cast<unsigned char>(text[j]) * static_cast<size_t>(w) + b] : 0;
+                }
+                eq = _mm256_set_epi64x(eqLane[3], eqLane[2], eqLane[1], eqLane[0]);
+                __m256i j = _mm256_sub_epi64(_mm256_set1_epi64x(t), laneIndex);
+                active = _mm256_and_si256(_mm256_cmpgt_epi64(j, _mm256_set1_epi64x(-1)),
+                                          _mm256_cmpgt_epi64(columns, j));
+            }
 
-    htmlFile << "</body></html>";              // Cierre del HTML
-    htmlFile.close();                          // Cerramos el archivo HTML
+            __m256i xv = _mm256_or_si256(eq, mv);
+            eq = _mm256_or_si256(eq, hinNeg);
+            __m256i xh = _mm256_or_si256(_mm256_xor_si256(_mm256_add_epi64(_mm256_and_si256(eq, pv), pv), pv), eq);
+            __m256i ph = _mm256_or_si256(mv, _mm256_andnot_si256(_mm256_or_si256(xh, pv), ones));
+            __m256i mh = _mm256_and_si256(pv, xh);
+            houtPos = _mm256_srli_epi64(ph, 63);
+            houtNeg = _mm256_srli_epi64(mh, 63);
+            __m256i rowDelta = _mm256_sub_epi64(_mm256_and_si256(_mm256_srl_epi64(ph, lastBit), one),
+                                                _mm256_and_si256(_mm256_srl_epi64(mh, lastBit), one));
+            scoreDelta = _mm256_add_epi64(scoreDelta, _mm256_and_si256(rowDelta, active));
+            ph = _mm256_or_si256(_mm256_slli_epi64(ph, 1), hinPos);
+            mh = _mm256_or_si256(_mm256_slli_epi64(mh, 1), hinNeg);
+            __m256i newPv = _mm256_or_si256(mh, _mm256_andnot_si256(_mm256_or_si256(xv, ph), ones));
+            __m256i newMv = _mm256_and_si256(ph, xv);
+            pv = _mm256_blendv_epi8(pv, newPv, active); // Los carriles fuera del frente no cambian
+            mv = _mm256_blendv_epi8(mv, newMv, active);
 
-    cout << "Archivo HTML generado: similar_texts.html" << endl; // Mensaje de confirmación
+            int jLast = t - (lanes - 1);       // Columna que procesó el último carril
+            if (jLast >= 0 && jLast < n) {
+                carryOut[jLast] = static_cast<signed char>(_mm256_extract_epi64(houtPos, 3) -
+                                                           _mm256_extract_epi64(houtNeg, 3));
+            }
+        }
+        if (lastBlock / lanes == g) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(delta), scoreDelta);
+        }
+        swap(carryIn, carryOut);
+    }
+    return pattern.length + static_cast<int>(delta[lastBlock % lanes]);
+}
+
+// Los intrínsecos de AVX-512 de GCC 12 parten de _mm512_undefined_*, y al expandirse en línea
+// -Wall -Wextra los marca como posibles lecturas sin inicializar; se silencian sólo en este núcleo
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+// Núcleo AVX-512: misma estrategia de frente diagonal con 8 bloques por vector
+__attribute__((target("avx512f"))) int myersEditDistanceAvx512(const MyersPattern &pattern, string_view text) {
+    const int lanes = 8;
+    int w = pattern.blocks;
+    int n = text.size();
+    int groups = (w + lanes - 1) / lanes;
+    int lastBlock = w - 1;
+    __m128i lastBit = _mm_cvtsi32_si128((pattern.length - 1) % 64);
+    ArenaScope scope;
+    ArenaVector<signed char> carryIn(n, 1), carryOut(n, 0);
+    const __m512i ones = _mm512_set1_epi64(-1);
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m512i laneIndex = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512i columns = _mm512_set1_epi64(n);
+    long long delta[lanes];
+
+    for (int g = 0; g < groups; ++g) {
+        __m512i pv = ones, mv = _mm512_setzero_si512();
+        __m512i houtPos = _mm512_setzero_si512(), houtNeg = _mm512_setzero_si512();
+        __m512i scoreDelta = _mm512_setzero_si512();
+        for (int t = 0; t < n + lanes - 1; ++t) {
+            long long inPos = t < n && carryIn[t] > 0, inNeg = t < n && carryIn[t] < 0;
+            // alignr desplaza los carriles una posición e inserta el acarreo del grupo anterior en el carril 0
+            __m512i hinPos = _mm512_alignr_epi64(houtPos, _mm512_set1_epi64(inPos), 7);
+            __m512i hinNeg = _mm512_alignr_epi64(houtNeg, _mm512_set1_epi64(inNeg), 7);
+            bool ramp = t < lanes - 1 || t >= n;   // Entrada o salida del frente: hay carriles inactivos
+            __m512i eq;
+            __mmask8 active = 0xFF;
+            if (!ramp && (g + 1) * lanes <= w) {
+                const unsigned char *column = reinterpret_cast<const unsigned char *>(text.data()) + t;
+                const uint64_t *block = pattern.peq.data() + g * lanes;
+                size_t stride = w;
+                eq = _mm512_set_epi64(block[column[-7] * stride + 7], block[column[-6] * stride + 6],
+                                      block[column[-5] * stride + 5], block[column[-4] * stride + 4],
+                                      block[column[-3] * stride + 3], block[column[-2] * stride + 2],
+                                      block[column[-1] * stride + 1], block[column[0] * stride]);
+            } else {
+                long long eqLane[lanes];
+                for (int l = 0; l < lanes; ++l) {
+                    int j = t - l, b = g * lanes + l;
+                    eqLane[l] = (j >= 0 && j < n && b < w)
+                        ? pattern.peq[static_cast<unsigned char>(text[j]) * static_cast<size_t>(w) + b] : 0;
+                }
+                eq = _mm512_loadu_si512(eqLane);
+                __m512i j = _mm512_sub_epi64(_mm512_set1_epi64(t), laneIndex);
+                active = _mm512_cmpge_epi64_mask(j, _mm512_setzero_si512()) & _mm512_cmplt_epi64_mask(j, columns);
+            }
+
+            __m512i xv = _mm512_or_si512(eq, mv);
+            eq = _mm512_or_si512(eq, hinNeg);
+            __m512i xh = _mm512_or_si512(_mm512_xor_si512(_mm512_add_epi64(_mm512_and_si512(eq, pv), pv), pv), eq);
+            __m512i ph = _mm512_or_si512(mv, _mm512_andnot_si512(_mm512_or_si512(xh, pv), ones));
+            __m512i mh = _mm512_and_si512(pv, xh);
+            houtPos = _mm512_srli_epi64(ph, 63);
+            houtNeg = _mm512_srli_epi64(mh, 63);
+            __m512i rowDelta = _mm512_sub_epi64(_mm512_and_si512(_mm512_srl_epi64(ph, lastBit), one),
+                                                _mm512_and_si512(_mm512_srl_epi64(mh, lastBit), one));
+            scoreDelta = _mm512_mask_add_epi64(scoreDelta, active, scoreDelta, rowDelta);
+            ph = _mm512_or_si512(_mm512_slli_epi64(ph, 1), hinPos);
+            mh = _mm512_or_si512(_mm512_slli_epi64(mh, 1), hinNeg);
+            pv = _mm512_mask_mov_epi64(pv, active, _mm512_or_si512(mh, _mm512_andnot_si512(_mm512_or_si512(xv, ph), ones)));
+            mv = _mm512_mask_mov_epi64(mv, active, _mm512_and_si512(ph, xv));
+
+            int jLast = t - (lanes - 1);
+            if (jLast >= 0 && jLast < n) {
+                long long outLane[lanes];
+                _mm512_storeu_si512(outLane, _mm512_sub_epi64(houtPos, houtNeg));
+                carryOut[jLast] = static_cast<signed char>(outLane[lanes - 1]);
+            }
+        }
+        if (lastBlock / lanes == g) {
+            _mm512_storeu_si512(delta, scoreDelta);
+        }
+        swap(carryIn, carryOut);
+    }
+    return pattern.length + static_cast<int>(delta[lastBlock % lanes]);
+}
+#pragma GCC diagnostic pop
+#endif
+
+// Función para saber si el procesador actual puede ejecutar una variante del núcleo de Myers
+bool myersVariantSupported(MyersVariant variant) {
+#ifdef HAVE_X86_SIMD
+    if (variant == MyersVariant::Avx512) return __builtin_cpu_supports("avx512f");
+    if (variant == MyersVariant::Avx2) return __builtin_cpu_supports("avx2");
+#endif
+    return variant == MyersVariant::Scalar;
+}
+
+// Función para calcular la distancia de edición con una variante concreta del núcleo de Myers
+int myersEditDistance(string_view str1, string_view str2, MyersVariant variant) {
+    string_view text = str1.size() >= str2.size() ? str1 : str2;    // Columnas
+    string_view pattern = str1.size() >= str2.size() ? str2 : str1; // Filas: la cadena más corta
+    if (pattern.empty()) {
+        return text.size();
+    }
+    countStat(runStats().dpCells, static_cast<uint64_t>(pattern.size()) * text.size());
+    ArenaScope scope;                          // La tabla del patrón se libera al terminar el par
+    MyersPattern compiled(pattern);
+#ifdef HAVE_X86_SIMD
+    if (variant == MyersVariant::Avx512) return myersEditDistanceAvx512(compiled, text);
+    if (variant == MyersVariant::Avx2) return myersEditDistanceAvx2(compiled, text);
+#endif
+    return myersEditDistanceScalar(compiled, text);
+}
+
+// Función para calcular la distancia de edición bit-paralela eligiendo la variante en tiempo de
+// ejecución: los vectores sólo convienen cuando el patrón llena al menos un vector de bloques
+int myersEditDistance(string_view str1, string_view str2) {
+    static const bool avx512 = myersVariantSupported(MyersVariant::Avx512);
+    static const bool avx2 = myersVariantSupported(MyersVariant::Avx2);
+    int blocks = (min(str1.size(), str2.size()) + 63) / 64;
+    if (avx512 && blocks >= 8) return myersEditDistance(str1, str2, MyersVariant::Avx512);
+    if (avx2 && blocks >= 4) return myersEditDistance(str1, str2, MyersVariant::Avx2);
+    return myersEditDistance(str1, str2, MyersVariant::Scalar);
+}
+
+// Función para generar los casos de prueba de los núcleos: cadenas aleatorias de varios tamaños y
+// alfabetos con ediciones aleatorias, y pares de documentos del corpus
+vector<pair<string, string>> kernelTestCases(const vector<string_view> &documents) {
+    vector<pair<string, string>> cases;
+    mt19937 rng(12345);                        // Semilla fija para que la prueba sea reproducible
+    for (int length : {1, 5, 63, 64, 65, 127, 200, 256, 513, 1000, 2100}) {
+        for (int alphabet : {2, 4, 26}) {
+            string a, b;
+            for (int i = 0; i < length; ++i) a += static_cast<char>('a' + rng() % alphabet);
+            b = a;
+            for (int e = 0; e < length / 7 + 1; ++e) { // Aplicamos ediciones aleatorias a la copia
+                size_t pos = rng() % (b.size() + 1);
+                int op = rng() % 3;
+                if (op == 0) b.insert(b.begin() + pos, static_cast<char>('a' + rng() % alphabet));
+                else if (pos < b.size() && op == 1) b.erase(b.begin() + pos);
+                else if (pos < b.size()) b[pos] = static_cast<char>('a' + rng() % alphabet);
+            }
+            cases.push_back({a, b});
+            cases.push_back({a, string(rng() % (2 * length), 'a')});
+        }
+    }
+    for (size_t i = 0; i + 1 < documents.size() && i < 40; i += 2) {
+        cases.push_back({string(documents[i]), string(documents[i + 1])});
+    }
+    return cases;
+}
+
+// Función para verificar todas las variantes disponibles del núcleo de Myers contra la DP, con
+// cadenas aleatorias de varios tamaños y con pares del corpus; devuelve el número de diferencias
+int verifyEditKernels(const vector<string_view> &documents) {
+    vector<pair<MyersVariant, const char *>> variants = {
+        {MyersVariant::Scalar, "escalar"}, {MyersVariant::Avx2, "AVX2"}, {MyersVariant::Avx512, "AVX-512"}};
+    vector<pair<string, string>> cases = kernelTestCases(documents);
+
+    int mismatches = 0;
+    for (const auto &variant : variants) {
+        if (!myersVariantSupported(variant.first)) {
+            cout << "Variante " << variant.second << ": no soportada por este procesador" << endl;
+            continue;
+        }
+        int failed = 0;
+        for (const auto &c : cases) {
+            if (myersEditDistance(c.first, c.second, variant.first) != editDistance<char>(c.first, c.second)) {
+                failed++;
+            }
+        }
+        cout << "Variante " << variant.second << ": " << cases.size() - failed << "/" << cases.size()
+             << " casos coinciden con la DP" << endl;
+        mismatches += failed;
+    }
+    return mismatches;
+}
+
+// Función para calcular la métrica de contención de Broder. Las subcadenas se comparan por su huella
+// FNV-1a incremental; con `verify` los conjuntos guardan intervalos y se comparan también los textos
+template <typename CharT>
+double broderContainment(basic_string_view<CharT> str1, basic_string_view<CharT> str2, bool verify = false) {
+    // Los conjuntos son planos y viven en la arena: ni copias ni un nodo por subcadena
+    ArenaScope scope;
+    // Llama visit(hash, inicio, longitud) para cada subcadena de str, extendiendo el hash desde cada inicio
+    auto forEachSubstring = [](basic_string_view<CharT> str, auto visit) {
+        for (size_t i = 0; i < str.size(); ++i) {
+            uint64_t hash = 0xcbf29ce484222325ULL; // FNV-1a extendido un símbolo a la vez desde i
+            for (size_t j = i + 1; j <= str.size(); ++j) {
+                const char *bytes = reinterpret_cast<const char *>(&str[j - 1]);
+                for (size_t b = 0; b < sizeof(CharT); ++b) {
+                    hash = (hash ^ static_cast<unsigned char>(bytes[b])) * 0x100000001b3ULL;
+                }
+                visit(mixHash(hash), i, j - i);
+            }
+        }
+    };
+    size_t expected1 = str1.size() * (str1.size() + 1) / 2;
+    size_t expected2 = str2.size() * (str2.size() + 1) / 2;
+
+    // Generamos subcadenas de str1 y de str2 y contamos las de str1 que están en str2
+    int countContained = 0;
+    size_t total;
+    if (verify) {
+        SpanHashSet<CharT> substrings1(str1, expected1, scope.get());
+        SpanHashSet<CharT> substrings2(str2, expected2, scope.get());
+        forEachSubstring(str1, [&](uint64_t hash, size_t i, size_t l) { substrings1.insert(hash, i, l); });
+        forEachSubstring(str2, [&](uint64_t hash, size_t i, size_t l) { substrings2.insert(hash, i, l); });
+        substrings1.forEach([&](uint64_t hash, basic_string_view<CharT> s) {
+            if (substrings2.contains(hash, s)) {
+                countContained++;
+            }
+        });
+        total = substrings1.size();
+    } else {
+        FingerprintSet substrings1(expected1, scope.get());
+        FingerprintSet substrings2(expected2, scope.get());
+        forEachSubstring(str1, [&](uint64_t hash, size_t, size_t) { substrings1.insert(hash); });
+        forEachSubstring(str2, [&](uint64_t hash, size_t, size_t) { substrings2.insert(hash); });
+        substrings1.forEach([&](uint64_t hash) {
+            if (substrings2.contains(hash)) {
+                countContained++;
+            }
+        });
+        total = substrings1.size();
+    }
+
+    return static_cast<double>(countContained) / total; // Proporción de subcadenas contenidas
+}
+
+// Función para escribir en `out` el hash de los k-shingles que empiezan en [first, last), en orden
+template <typename Symbol>
+void rollingShingleRange(const Symbol *data, int k, size_t first, size_t last, uint64_t *out) {
+    const uint64_t power = rollingPower(k);
+    uint64_t hash = 0;
+    for (int i = 0; i < k; ++i) {
+        hash = hash * rollingBase + rollingSymbol(data[first + i]);
+    }
+    for (size_t p = first; p < last; ++p) {
+        if (p > first) {                       // Entra data[p + k - 1] y sale data[p - 1]
+            hash = hash * rollingBase + rollingSymbol(data[p + k - 1]) - power * rollingSymbol(data[p - 1]);
+        }
+        *out++ = mixHash(hash);
+    }
+}
+
+#ifdef HAVE_X86_SIMD
+// Como en myersEditDistanceAvx512, se silencian los avisos de los intrínsecos de GCC 12 expandidos en línea
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+// mixHash en los 8 carriles de un vector
+__attribute__((target("avx512f,avx512dq"))) inline __m512i mixHashAvx512(__m512i value) {
+    value = _mm512_xor_si512(value, _mm512_srli_epi64(value, 30));
+    value = _mm512_mullo_epi64(value, _mm512_set1_epi64(static_cast<long long>(0xbf58476d1ce4e5b9ULL)));
+    value = _mm512_xor_si512(value, _mm512_srli_epi64(value, 27));
+    value = _mm512_mullo_epi64(value, _mm512_set1_epi64(static_cast<long long>(0x94d049bb133111ebULL)));
+    return _mm512_xor_si512(value, _mm512_srli_epi64(value, 31));
+}
+
+// Variante AVX-512 para bytes: el texto se divide en 8 segmentos y cada carril del vector lleva el
+// hash rodante de uno, así que las 8 cadenas de dependencias avanzan a la vez. Los bytes se leen con
+// un gather de 8 bytes por carril cada 8 posiciones. Los hashes se escriben intercalados por carril
+// (el orden no importa porque después se ordenan); el resto de cada segmento se hace en escalar
+__attribute__((target("avx512f,avx512dq"))) void rollingShingleHashesAvx512(const char *data, size_t size, int k,
+                                                                           uint64_t *out) {
+    size_t count = size - k + 1;               // Número de shingles
+    size_t segment = count / 8;                // Posiciones por carril
+    const uint64_t power = rollingPower(k);
+    alignas(64) uint64_t lanes[8];
+    for (int l = 0; l < 8; ++l) {
+        uint64_t hash = 0;
+        for (int i = 0; i < k; ++i) hash = hash * rollingBase + static_cast<unsigned char>(data[l * segment + i]);
+        lanes[l] = hash;
+    }
+    const __m512i base = _mm512_set1_epi64(static_cast<long long>(rollingBase));
+    const __m512i weight = _mm512_set1_epi64(static_cast<long long>(power));
+    const __m512i low = _mm512_set1_epi64(0xff);
+    const __m512i starts = _mm512_mullo_epi64(_mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0),
+                                              _mm512_set1_epi64(static_cast<long long>(segment)));
+    __m512i hash = _mm512_load_si512(lanes);
+    _mm512_storeu_si512(out, mixHashAvx512(hash));
+    out += 8;
+    size_t t = 1;                              // Posición dentro del segmento
+    for (; t + 8 <= segment; t += 8) {
+        // Bytes que entran (t + k - 1 ...) y que salen (t - 1 ...) en las próximas 8 posiciones
+        __m512i incoming = _mm512_i64gather_epi64(_mm512_add_epi64(starts, _mm512_set1_epi64(t + k - 1)), data, 1);
+        __m512i outgoing = _mm512_i64gather_epi64(_mm512_add_epi64(starts, _mm512_set1_epi64(t - 1)), data, 1);
+        for (int s = 0; s < 8; ++s) {
+            hash = _mm512_add_epi64(_mm512_mullo_epi64(hash, base), _mm512_and_si512(incoming, low));
+            hash = _mm512_sub_epi64(hash, _mm512_mullo_epi64(weight, _mm512_and_si512(outgoing, low)));
+            incoming = _mm512_srli_epi64(incoming, 8);
+            outgoing = _mm512_srli_epi64(outgoing, 8);
+            _mm512_storeu_si512(out, mixHashAvx512(hash));
+            out += 8;
+        }
+    }
+    _mm512_store_si512(lanes, hash);
+    for (int l = 0; l < 8; ++l) {              // Resto de cada segmento
+        uint64_t laneHash = lanes[l];
+        for (size_t p = l * segment + t; p < (l + 1) * segment; ++p) {
+            laneHash = laneHash * rollingBase + static_cast<unsigned char>(data[p + k - 1]) -
+                       power * static_cast<unsigned char>(data[p - 1]);
+            *out++ = mixHash(laneHash);
+        }
+    }
+    if (8 * segment < count) {                 // Posiciones que no llenan un segmento por carril
+        rollingShingleRange(data, k, 8 * segment, count, out);
+    }
+}
+#pragma GCC diagnostic pop
+#endif
+
+// Función para escribir en `out` (con espacio para size - k + 1 valores) el hash de todos los
+// k-shingles de una secuencia en una sola pasada. Con bytes y AVX-512 se usan 8 carriles; en ese
+// caso el orden de salida no es posicional
+template <typename Symbol>
+void rollingShingleHashes(const Symbol *data, size_t size, int k, uint64_t *out, bool allowSimd = true) {
+#ifdef HAVE_X86_SIMD
+    if constexpr (is_same_v<Symbol, char>) {
+        static const bool avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+        if (allowSimd && avx512 && size - k + 1 >= 256) {
+            rollingShingleHashesAvx512(data, size, k, out);
+            return;
+        }
+    }
+#endif
+    rollingShingleRange(data, k, 0, size - k + 1, out);
+}
+
+// Función para obtener los hashes distintos y ordenados de todos los k-shingles de una secuencia de
+// `size` símbolos (bytes, identificadores o hashes de palabras); cada shingle son k símbolos consecutivos
+// El resultado se deja en `hashes`, que puede ser un vector de la arena
+template <typename Symbol, typename Container>
+void shingleHashes(const Symbol *data, size_t size, int k, Container &hashes) {
+    hashes.clear();
+    if (k <= 0 || size < static_cast<size_t>(k)) {
+        return;                                    // La secuencia no tiene ningún shingle
+    }
+    hashes.resize(size - k + 1);
+    rollingShingleHashes(data, size, k, hashes.data());
+    sort(hashes.begin(), hashes.end());
+    hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+}
+
+template <typename Symbol>
+vector<uint64_t> shingleHashes(const Symbol *data, size_t size, int k) {
+    vector<uint64_t> hashes;
+    shingleHashes(data, size, k, hashes);
+    return hashes;
+}
+
+template <typename CharT>
+vector<uint64_t> shingleHashes(basic_string_view<CharT> str, int k) {
+    return shingleHashes(str.data(), str.size(), k);
+}
+
+// Boceto bottom-k de los k-shingles de un documento
+struct ShingleSketch {
+    vector<uint64_t> minHashes;  // Los hashes más pequeños del conjunto, en orden ascendente
+    size_t shingleCount = 0;     // Número total de shingles distintos del documento
+};
+
+// Función para construir el boceto MinHash (bottom-k) a partir de los hashes distintos y ordenados
+ShingleSketch buildSketch(const vector<uint64_t> &hashes, size_t sketchSize) {
+    ShingleSketch sketch;
+    sketch.shingleCount = hashes.size();
+    sketch.minHashes.assign(hashes.begin(), hashes.begin() + min(hashes.size(), sketchSize)); // Los más pequeños
+    return sketch;
+}
+
+// Función para construir el boceto MinHash (bottom-k) de una cadena; se calcula una vez por documento
+template <typename CharT>
+ShingleSketch buildSketch(basic_string_view<CharT> str, int k, size_t sketchSize) {
+    return buildSketch(shingleHashes(str, k), sketchSize);
+}
+
+// Función para estimar la contención de Broder |A ∩ B| / |A| a partir de dos bocetos bottom-k.
+// Se estima la similitud de Jaccard J con el boceto de la unión y se despeja
+// |A ∩ B| = J * (|A| + |B|) / (1 + J). Complejidad O(tamaño del boceto)
+double sketchContainment(const ShingleSketch &a, const ShingleSketch &b) {
+    if (a.shingleCount == 0 || b.shingleCount == 0) {
+        return 0.0;
+    }
+    size_t limit = max(a.minHashes.size(), b.minHashes.size()); // Tamaño del boceto de la unión
+    size_t ia = 0, ib = 0, taken = 0, shared = 0;
+    while (taken < limit && (ia < a.minHashes.size() || ib < b.minHashes.size())) {
+        if (ib == b.minHashes.size() || (ia < a.minHashes.size() && a.minHashes[ia] < b.minHashes[ib])) {
+            ia++;                                  // Hash presente sólo en el boceto de A
+        } else if (ia == a.minHashes.size() || b.minHashes[ib] < a.minHashes[ia]) {
+            ib++;                                  // Hash presente sólo en el boceto de B
+        } else {
+            ia++;                                  // Hash presente en ambos
+            ib++;
+            shared++;
+        }
+        taken++;
+    }
+    double jaccard = static_cast<double>(shared) / taken;
+    double intersection = jaccard * (a.shingleCount + b.shingleCount) / (1.0 + jaccard);
+    return min(1.0, intersection / a.shingleCount);
+}
+
+// Función para calcular la contención de Broder exacta sobre k-shingles (para validar los bocetos)
+template <typename CharT>
+double shingleContainment(basic_string_view<CharT> str1, basic_string_view<CharT> str2, int k) {
+    ArenaScope scope;                          // Los hashes de ambos documentos viven en la arena
+    ArenaVector<uint64_t> hashes1{ArenaAllocator<uint64_t>(scope.get())};
+    ArenaVector<uint64_t> hashes2{ArenaAllocator<uint64_t>(scope.get())};
+    shingleHashes(str1.data(), str1.size(), k, hashes1);
+    shingleHashes(str2.data(), str2.size(), k, hashes2);
+    if (hashes1.empty()) {
+        return 0.0;
+    }
+    size_t common = 0;                         // Intersección por mezcla de las dos listas ordenadas
+    for (size_t a = 0, b = 0; a < hashes1.size() && b < hashes2.size();) {
+        if (hashes1[a] < hashes2[b]) {
+            a++;
+        } else if (hashes2[b] < hashes1[a]) {
+            b++;
+        } else {
+            common++;
+            a++;
+            b++;
+        }
+    }
+    return static_cast<double>(common) / hashes1.size();
+}
+
+// Función para medir la generación de k-shingles sobre el corpus con cuatro métodos: un
+// unordered_set<string> de subcadenas (como la contención de Broder original), FNV-1a recalculado en
+// cada posición, el hash rodante escalar y su variante vectorial. Además comprueba que ambas
+// variantes rodantes producen el mismo conjunto y que no hay colisiones respecto a las cadenas;
+// devuelve el número de documentos con diferencias
+int benchmarkShingles(const vector<string_view> &documents, int k) {
+    using Clock = chrono::steady_clock;
+    size_t shingles = 0;                       // Shingles del corpus en una pasada
+    for (auto document : documents) {
+        if (document.size() >= static_cast<size_t>(k)) shingles += document.size() - k + 1;
+    }
+    if (shingles == 0) {
+        cout << "El corpus no tiene shingles de longitud " << k << endl;
+        return 0;
+    }
+    int repetitions = max<size_t>(1, 20000000 / shingles); // Al menos ~2e7 shingles por método
+    auto report = [&](const char *name, Clock::time_point start, uint64_t checksum) {
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+        cout << fixed << setprecision(2) << name << ": " << seconds * 1e3 << " ms, "
+             << seconds * 1e9 / (static_cast<double>(shingles) * repetitions) << " ns/shingle"
+             << " (control " << (checksum & 0xffff) << ")" << endl;
+    };
+    cout << "Shingles de " << k << " bytes: " << shingles << " x " << repetitions << " repeticiones" << endl;
+
+    vector<size_t> distinctStrings(documents.size());
+    Clock::time_point start = Clock::now();
+    uint64_t checksum = 0;
+    for (int r = 0; r < repetitions; ++r) {
+        for (size_t d = 0; d < documents.size(); ++d) {
+            unordered_set<string> substrings;
+            for (size_t i = 0; i + k <= documents[d].size(); ++i) {
+                substrings.insert(string(documents[d].substr(i, k))); // Una asignación por shingle
+            }
+            distinctStrings[d] = substrings.size();
+            checksum += substrings.size();
+        }
+    }
+    report("unordered_set<string>", start, checksum);
+
+    vector<uint64_t> scalar, vectorized;
+    start = Clock::now();
+    checksum = 0;
+    for (int r = 0; r < repetitions; ++r) {
+        for (auto document : documents) {
+            for (size_t i = 0; i + k <= document.size(); ++i) {
+                checksum += hashShingle(document.data() + i, k);
+            }
+        }
+    }
+    report("FNV-1a por posición", start, checksum);
+
+    for (int variant = 0; variant < 2; ++variant) {
+        start = Clock::now();
+        checksum = 0;
+        for (int r = 0; r < repetitions; ++r) {
+            for (auto document : documents) {
+                if (document.size() < static_cast<size_t>(k)) continue;
+                vector<uint64_t> &out = variant == 0 ? scalar : vectorized;
+                out.resize(document.size() - k + 1);
+                rollingShingleHashes(document.data(), document.size(), k, out.data(), variant == 1);
+                checksum += out.back();
+            }
+        }
+        report(variant == 0 ? "Hash rodante escalar" : "Hash rodante vectorial", start, checksum);
+    }
+
+    int mismatches = 0;
+    for (size_t d = 0; d < documents.size(); ++d) {
+        size_t size = documents[d].size();
+        if (size < static_cast<size_t>(k)) continue;
+        scalar.resize(size - k + 1);
+        vectorized.resize(size - k + 1);
+        rollingShingleHashes(documents[d].data(), size, k, scalar.data(), false);
+        rollingShingleHashes(documents[d].data(), size, k, vectorized.data(), true);
+        sort(scalar.begin(), scalar.end());
+        sort(vectorized.begin(), vectorized.end());
+        bool same = scalar == vectorized;
+        size_t distinct = unique(scalar.begin(), scalar.end()) - scalar.begin(); // Sin colisiones = mismas cadenas
+        mismatches += !same || distinct != distinctStrings[d];
+    }
+    cout << "Documentos con diferencias entre métodos: " << mismatches << endl;
+    return mismatches;
+}
+
+// Planificador con robo de trabajo: cada hilo consume su propia cola por el final y, cuando se
+// vacía, roba tareas del principio de la cola de otro hilo. Sirve para tareas de costo muy
+// desigual, como las filas del triángulo superior de la matriz de similitud
+class WorkStealingScheduler {
+public:
+    explicit WorkStealingScheduler(int threadCount) : queues(max(1, threadCount)) {}
+
+    int threadCount() const { return queues.size(); }
+
+    // Ejecuta task(tarea, hilo) para cada tarea en [0, taskCount) y espera a que terminen todas
+    void run(int taskCount, const function<void(int, int)> &task) {
+        int threads = queues.size();
+        for (int t = 0; t < taskCount; ++t) {
+            queues[t % threads].tasks.push_back(t);   // Reparto inicial intercalado
+        }
+        vector<thread> workers;
+        for (int w = 1; w < threads; ++w) {
+            workers.emplace_back([&, w] { work(w, task); });
+        }
+        work(0, task);                                // El hilo principal también trabaja
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+private:
+    struct TaskQueue {
+        mutex lock;        // Protege la cola; la contención sólo ocurre al robar
+        deque<int> tasks;  // Tareas pendientes del hilo
+    };
+
+    vector<TaskQueue> queues;  // Una cola por hilo
+
+    // Obtiene la siguiente tarea: primero de la cola propia, luego robando a los demás hilos
+    bool next(int self, int &task) {
+        {
+            lock_guard<mutex> guard(queues[self].lock);
+            if (!queues[self].tasks.empty()) {
+                task = queues[self].tasks.back();
+                queues[self].tasks.pop_back();
+                return true;
+            }
+        }
+        int threads = queues.size();
+        for (int offset = 1; offset < threads; ++offset) {
+            TaskQueue &victim = queues[(self + offset) % threads];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();          // Robamos la tarea más antigua de la víctima
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;                                 // No se crean tareas nuevas: ya terminamos
+    }
+
+    void work(int self, const function<void(int, int)> &task) {
+        int current;
+        chrono::steady_clock::duration busy{};        // Tiempo dentro de las tareas, sin la espera
+        while (next(self, current)) {
+            auto start = chrono::steady_clock::now();
+            task(current, self);
+            busy += chrono::steady_clock::now() - start;
+        }
+        runStats().addBusy(self, chrono::duration<double>(busy).count());
+    }
+};
+
+// Índice invertido de shingles: para cada hash de `minLength`-grama, los documentos que lo contienen.
+// Dos documentos sólo pueden tener similitud mayor que 0 si comparten al menos un shingle, así que
+// el índice genera únicamente los pares candidatos y el resto se omite con similitud 0. Si se exigen
+// t > 1 shingles en común se aplica además el filtro de prefijos de AllPairs/PPJoin: con los hashes
+// de cada documento ordenados del menos al más frecuente del corpus, dos documentos que comparten al
+// menos t tienen que compartir alguno de sus primeros |S| - t + 1, así que sólo se recorren las
+// listas de ese prefijo y cada candidato se verifica contando la intersección exacta
+class ShingleIndex {
+public:
+    // Construye el índice a partir de los hashes distintos y ordenados de cada documento. El
+    // índice no copia las listas: `shingles` debe seguir vivo mientras se use el índice. Con
+    // `prefixOverlap` > 1 se construye también el índice de prefijos para ese número de shingles
+    void build(const vector<vector<uint64_t>> &shingles, int prefixOverlap = 1) {
+        documentShingles = &shingles;
+        vector<pair<uint64_t, int>> entries;   // Pares (hash, documento) de todo el corpus
+        for (int d = 0; d < static_cast<int>(shingles.size()); ++d) {
+            for (uint64_t hash : shingles[d]) {
+                entries.push_back({hash, d});
+            }
+        }
+        sort(entries.begin(), entries.end());  // Agrupa por hash con los documentos en orden
+        keys.clear();
+        offsets.clear();
+        postings.clear();
+        postings.reserve(entries.size());
+        for (size_t e = 0; e < entries.size(); ++e) {
+            if (e == 0 || entries[e].first != entries[e - 1].first) {
+                keys.push_back(entries[e].first);
+                offsets.push_back(postings.size());
+            }
+            postings.push_back(entries[e].second);
+        }
+        offsets.push_back(postings.size());
+        overlap = max(1, prefixOverlap);
+        if (overlap > 1) {
+            buildPrefixes();
+        }
+    }
+
+    int documentCount() const { return documentShingles->size(); }
+
+    // Número de shingles distintos del documento d
+    int shingleCount(int d) const { return (*documentShingles)[d].size(); }
+
+    // Devuelve en `out` los documentos j >= firstColumn (por defecto j > i), distintos de i, que
+    // comparten al menos `minShared` shingles con i y, si `shared` no es nulo, cuántos comparte cada
+    // uno. `counts` debe tener un elemento por documento en 0; se deja en 0 al terminar
+    void candidates(int i, int minShared, vector<int> &counts, vector<int> &touched, vector<int> &out,
+                    int firstColumn = -1, vector<int> *shared = nullptr) const {
+        if (overlap > 1 && minShared == overlap) {
+            prefixCandidates(i, counts, touched, out, firstColumn, shared);
+            return;
+        }
+        int firstCandidate = firstColumn < 0 ? i + 1 : firstColumn;
+        out.clear();
+        touched.clear();                       // Documentos cuyo contador se modificó
+        size_t from = 0;                       // Los shingles de i están ordenados: búsqueda creciente
+        for (uint64_t hash : (*documentShingles)[i]) {
+            size_t k = lower_bound(keys.begin() + from, keys.end(), hash) - keys.begin();
+            from = k;
+            const int *begin = postings.data() + offsets[k];
+            const int *end = postings.data() + offsets[k + 1];
+            for (const int *p = lower_bound(begin, end, firstCandidate); p != end; ++p) { // Sólo j >= firstCandidate
+                if (*p == i) {
+                    continue;
+                }
+                if (counts[*p]++ == 0) {
+                    touched.push_back(*p);
+                }
+                if (counts[*p] == minShared) {
+                    out.push_back(*p);
+                }
+            }
+        }
+        sort(out.begin(), out.end());
+        if (shared != nullptr) {
+            shared->clear();
+            for (int j : out) shared->push_back(counts[j]);
+        }
+        for (int d : touched) {
+            counts[d] = 0;
+        }
+    }
+
+private:
+    const vector<vector<uint64_t>> *documentShingles = nullptr; // Shingles distintos de cada documento
+    vector<uint64_t> keys;                      // Hashes distintos del corpus, ordenados
+    vector<size_t> offsets;                     // Inicio de la lista de cada hash en `postings`
+    vector<int> postings;                       // Documentos de cada hash, en orden creciente
+    int overlap = 1;                            // Shingles en común del índice de prefijos (1 = sin él)
+    vector<size_t> prefixStart;                 // Inicio del prefijo de cada documento en `prefixKeys`
+    vector<int> prefixKeys;                     // Hashes (posición en `keys`) del prefijo de cada documento
+    vector<size_t> prefixOffsets;               // Inicio de la lista de cada hash en `prefixPostings`
+    vector<int> prefixPostings;                 // Documentos que tienen el hash en su prefijo
+
+    // Calcula el prefijo de cada documento (sus |S| - overlap + 1 hashes menos frecuentes, en el orden
+    // global por frecuencia y hash) y las listas de documentos de cada hash restringidas a los prefijos
+    void buildPrefixes() {
+        int n = documentShingles->size();
+        size_t keyCount = keys.size();
+        vector<int> rank(keyCount);               // Posición de cada hash en el orden global
+        vector<int> byFrequency(keyCount);
+        iota(byFrequency.begin(), byFrequency.end(), 0);
+        sort(byFrequency.begin(), byFrequency.end(), [&](int a, int b) {
+            size_t fa = offsets[a + 1] - offsets[a], fb = offsets[b + 1] - offsets[b];
+            return fa != fb ? fa < fb : a < b;
+        });
+        for (size_t r = 0; r < keyCount; ++r) rank[byFrequency[r]] = r;
+        prefixStart.assign(1, 0);
+        prefixKeys.clear();
+        vector<int> local;                        // Hashes del documento en el orden global
+        for (int d = 0; d < n; ++d) {
+            const vector<uint64_t> &hashes = (*documentShingles)[d];
+            local.clear();
+            size_t from = 0;
+            for (uint64_t hash : hashes) {
+                from = lower_bound(keys.begin() + from, keys.end(), hash) - keys.begin();
+                local.push_back(from);
+            }
+            sort(local.begin(), local.end(), [&](int a, int b) { return rank[a] < rank[b]; });
+            int length = max(0, static_cast<int>(local.size()) - overlap + 1); // Sin prefijo si |S| < overlap
+            prefixKeys.insert(prefixKeys.end(), local.begin(), local.begin() + length);
+            prefixStart.push_back(prefixKeys.size());
+        }
+        prefixOffsets.assign(keyCount + 1, 0);
+        for (int k : prefixKeys) prefixOffsets[k + 1]++;
+        for (size_t k = 0; k < keyCount; ++k) prefixOffsets[k + 1] += prefixOffsets[k];
+        prefixPostings.assign(prefixKeys.size(), 0);
+        vector<size_t> fill(prefixOffsets.begin(), prefixOffsets.end() - 1);
+        for (int d = 0; d < n; ++d) {             // Documentos en orden creciente en cada lista
+            for (size_t p = prefixStart[d]; p < prefixStart[d + 1]; ++p) {
+                prefixPostings[fill[prefixKeys[p]]++] = d;
+            }
+        }
+    }
+
+    // Candidatos con el filtro de prefijos: documentos que comparten algún hash del prefijo de i en
+    // su propio prefijo, verificados contando la intersección de ambas listas ordenadas
+    void prefixCandidates(int i, vector<int> &counts, vector<int> &touched, vector<int> &out, int firstColumn,
+                          vector<int> *shared) const {
+        int firstCandidate = firstColumn < 0 ? i + 1 : firstColumn;
+        out.clear();
+        touched.clear();
+        for (size_t p = prefixStart[i]; p < prefixStart[i + 1]; ++p) {
+            int k = prefixKeys[p];
+            const int *begin = prefixPostings.data() + prefixOffsets[k];
+            const int *end = prefixPostings.data() + prefixOffsets[k + 1];
+            for (const int *d = lower_bound(begin, end, firstCandidate); d != end; ++d) {
+                if (*d != i && counts[*d] == 0) {
+                    counts[*d] = 1;
+                    touched.push_back(*d);
+                }
+            }
+        }
+        sort(touched.begin(), touched.end());
+        if (shared != nullptr) shared->clear();
+        const vector<uint64_t> &mine = (*documentShingles)[i];
+        for (int d : touched) {
+            counts[d] = 0;
+            const vector<uint64_t> &theirs = (*documentShingles)[d];
+            int common = 0;                       // Intersección exacta de los hashes ordenados
+            for (size_t a = 0, b = 0; a < mine.size() && b < theirs.size();) {
+                if (mine[a] < theirs[b]) {
+                    a++;
+                } else if (theirs[b] < mine[a]) {
+                    b++;
+                } else {
+                    common++;
+                    a++;
+                    b++;
+                }
+            }
+            if (common >= overlap) {
+                out.push_back(d);
+                if (shared != nullptr) shared->push_back(common);
+            }
+        }
+    }
+};
+
+// Memoria temporal de un hilo para evaluar pares; se reutiliza en lugar de reservarse por par
+template <typename CharT>
+struct PairScratch {
+    BasicSuffixAutomaton<CharT> automaton; // Autómata del documento de la fila actual
+    CoverageScratch coverage;   // Ventanas de la fila para la similitud por cobertura
+    MassScratch mass;           // Memoria de commonSubstringMass
+    vector<int> counts;         // Contadores de shingles compartidos por documento
+    vector<int> touched;        // Documentos con contador distinto de 0
+    vector<int> candidates;     // Columnas candidatas de la fila actual
+    vector<int> shared;         // Shingles que comparte cada candidata con la fila
+};
+
+// Función para preparar la fila `row`: su autómata y, para la cobertura, sus ventanas
+template <typename CharT>
+void prepareRow(basic_string_view<CharT> row, int minLength, SimilarityMode mode, PairScratch<CharT> &local) {
+    local.automaton.build(row);
+    if (mode == SimilarityMode::Coverage) {
+        prepareCoverage(row, local.automaton, minLength, local.coverage);
+    }
+}
+
+// Métricas de un par que salen de un único recorrido del otro texto sobre el autómata de la fila
+struct PairMetrics {
+    double coverage = 0.0;      // Similitud por cobertura
+    double containment = 0.0;   // Contención exacta de los k-shingles de la fila en el otro texto
+    optional<int> editDistance; // Distancia de edición acotada (sólo con un umbral)
+};
+
+// Función para preparar la fila `row` para rowPairMetrics: su autómata, sus ventanas de minLength y
+// sus k-shingles
+template <typename CharT>
+void prepareRowMetrics(basic_string_view<CharT> row, int minLength, int k, PairScratch<CharT> &local) {
+    prepareRow(row, minLength, SimilarityMode::Coverage, local);
+    local.coverage.shingles.prepare(local.automaton, k);
+}
+
+// Función para calcular las métricas del par (row, other) con la fila ya preparada en `local`: la
+// cobertura y la contención salen del mismo recorrido de `other` (coverageSimilarity) y, si
+// `maxDistance` >= 0, se añade la distancia de edición acotada por la banda. O(|row| + |other|) más
+// O(maxDistance * min(|row|, |other|)) de la banda
+template <typename CharT>
+PairMetrics rowPairMetrics(basic_string_view<CharT> row, basic_string_view<CharT> other, int minLength,
+                           int maxDistance, PairScratch<CharT> &local) {
+    PairMetrics metrics;
+    metrics.coverage = coverageSimilarity(row, other, local.automaton, minLength, local.coverage, &metrics.containment);
+    if (maxDistance >= 0) {
+        metrics.editDistance = boundedEditDistance(row, other, maxDistance);
+    }
+    return metrics;
+}
+
+// Función para calcular la similitud del par (row, other) con la fila ya preparada en `local`
+template <typename CharT>
+double rowPairSimilarity(basic_string_view<CharT> row, basic_string_view<CharT> other, int minLength,
+                         SimilarityMode mode, PairScratch<CharT> &local) {
+    if (mode == SimilarityMode::Coverage) {
+        return rowPairMetrics(row, other, minLength, -1, local).coverage;
+    }
+    // La suma de subcadenas comunes es simétrica, así que recorremos `other` sobre el autómata de `row`
+    long long totalLength = commonSubstringMass(other, local.automaton, minLength, local.mass);
+    int maxLength = max(row.size(), other.size());
+    return static_cast<double>(totalLength) / maxLength;
+}
+
+// Función para calcular la similitud del par (row, other) con el motor elegido: con el autómata, la
+// fila se prepara en `local` la primera vez que se pide (`prepared`) y se reutiliza en sus demás
+// pares; con la tabla DP cada par se calcula completo con similarityMetric
+template <typename CharT>
+double backendPairSimilarity(basic_string_view<CharT> row, basic_string_view<CharT> other, int minLength,
+                             SimilarityMode mode, SubstringBackend backend, bool verifySpans,
+                             PairScratch<CharT> &local, bool &prepared) {
+    if (backend != SubstringBackend::SuffixAutomaton) {
+        return similarityMetric(row, other, minLength, backend, verifySpans, mode);
+    }
+    if (!prepared) {
+        prepareRow(row, minLength, mode, local);
+        prepared = true;
+    }
+    return rowPairSimilarity(row, other, minLength, mode, local);
+}
+
+// Función para verificar rowPairMetrics contra los cálculos por separado (coverageSimilarity con su
+// propio autómata, shingleContainment y boundedEditDistance) con los casos de kernelTestCases; las
+// filas repetidas se preparan una sola vez, como en la exportación. Devuelve el número de diferencias
+int verifyPairMetrics(const vector<string_view> &documents, int minLength, int k) {
+    const int maxDistance = 32;
+    vector<pair<string, string>> cases = kernelTestCases(documents);
+    PairScratch<char> local;
+    const string *preparedRow = nullptr;
+    int failed = 0;
+    for (const auto &c : cases) {
+        string_view row = c.first, other = c.second;
+        if (preparedRow == nullptr || *preparedRow != c.first) {
+            prepareRowMetrics(row, minLength, k, local);
+            preparedRow = &c.first;
+        }
+        PairMetrics metrics = rowPairMetrics(row, other, minLength, maxDistance, local);
+        if (metrics.coverage != similarityMetric(row, other, minLength, SubstringBackend::SuffixAutomaton, false,
+                                                 SimilarityMode::Coverage) ||
+            metrics.containment != shingleContainment(row, other, k) ||
+            metrics.editDistance != boundedEditDistance(row, other, maxDistance)) {
+            failed++;
+        }
+    }
+    cout << "Métricas de un recorrido: " << cases.size() - failed << "/" << cases.size()
+         << " casos coinciden con el cálculo por separado" << endl;
+    return failed;
+}
+
+// Función para acotar la similitud de un par sin leer su contenido, con las longitudes de ambas
+// secuencias, sus shingles distintos del índice (de longitud minLength) y los que comparten. En la
+// cobertura, un carácter cubierto pertenece a una ventana de minLength que aparece en ambos textos;
+// las posiciones de X con una ventana común son a lo más las `shared` primeras apariciones más las
+// ventanas repetidas de X (sus ventanas menos sus shingles distintos), y cada una cubre minLength
+// caracteres. La masa suma las longitudes de subcadenas comunes distintas, que pueden pasar de la
+// longitud del texto menor, así que no tiene una cota útil y se devuelve infinito
+double similarityUpperBound(SimilarityMode mode, int length1, int length2, int distinct1, int distinct2, int shared,
+                            int minLength) {
+    if (mode != SimilarityMode::Coverage) {
+        return numeric_limits<double>::infinity();
+    }
+    if (length1 + length2 == 0) {
+        return 0.0;
+    }
+    auto covered = [&](int length, int distinct) {
+        long long repeated = max(0, length - minLength + 1) - distinct; // Ventanas repetidas del texto
+        return min<long long>(length, (shared + repeated) * minLength);
+    };
+    return static_cast<double>(covered(length1, distinct1) + covered(length2, distinct2)) / (length1 + length2);
+}
+
+// Par de documentos con su similitud
+struct ScoredPair {
+    int first;          // Índice del primer documento (first < second)
+    int second;         // Índice del segundo documento
+    double similarity;  // Similitud del par
+};
+
+// Función para comparar pares de documentos por similitud. Retorna true si la similitud del par `a`
+// es mayor que la del par `b`; en empate gana el de menores índices, para que la selección no
+// dependa del orden en que se evaluaron los pares
+bool comparePairs(const ScoredPair &a, const ScoredPair &b) {
+    if (a.similarity != b.similarity) return a.similarity > b.similarity;
+    if (a.first != b.first) return a.first < b.first;
+    return a.second < b.second;
+}
+
+// Montículo acotado que conserva los `capacity` mejores pares vistos hasta ahora
+class TopKPairs {
+public:
+    explicit TopKPairs(size_t capacity) : capacity(capacity) {}
+
+    void push(const ScoredPair &pair) {
+        if (capacity == 0) return;
+        if (heap.size() < capacity) {
+            heap.push_back(pair);
+            push_heap(heap.begin(), heap.end(), comparePairs); // La raíz es el peor par conservado
+        } else if (comparePairs(pair, heap.front())) {
+            pop_heap(heap.begin(), heap.end(), comparePairs);
+            heap.back() = pair;
+            push_heap(heap.begin(), heap.end(), comparePairs);
+        }
+    }
+
+    // Agrega los pares de otro montículo (por ejemplo, el de otro hilo)
+    void merge(const TopKPairs &other) {
+        for (const auto &pair : other.heap) push(pair);
+    }
+
+    // Devuelve los pares conservados del mejor al peor
+    vector<ScoredPair> sorted() const {
+        vector<ScoredPair> result = heap;
+        sort(result.begin(), result.end(), comparePairs);
+        return result;
+    }
+
+    // Peor par conservado; sólo es válido cuando el montículo está lleno
+    bool full() const { return capacity > 0 && heap.size() == capacity; }
+    const ScoredPair &worst() const { return heap.front(); }
+
+private:
+    size_t capacity;           // Número máximo de pares conservados
+    vector<ScoredPair> heap;   // Montículo con el peor par en la raíz
+};
+
+// Recolector de los K mejores pares mientras se generan: cada hilo tiene su propio montículo
+// acotado, sin sincronización, y al final se combinan. Nunca se guardan los O(n^2) pares
+class TopKCollector {
+public:
+    TopKCollector(size_t k, int threadCount) : k(k), heaps(max(1, threadCount), TopKPairs(k)) {}
+
+    void push(int worker, const ScoredPair &pair) { heaps[worker].push(pair); }
+
+    // Similitud que debe alcanzar un par para entrar en el montículo del hilo: la del peor par
+    // conservado una vez lleno, o -infinito. Sólo sube durante la ejecución, y un par por debajo de
+    // ella tampoco puede estar entre los K mejores del total
+    double threshold(int worker) const {
+        const TopKPairs &heap = heaps[worker];
+        return heap.full() ? heap.worst().similarity : -numeric_limits<double>::infinity();
+    }
+
+    // Combina los montículos de todos los hilos y devuelve los K mejores, del mejor al peor
+    vector<ScoredPair> result() const {
+        TopKPairs best(k);
+        for (const auto &heap : heaps) best.merge(heap);
+        return best.sorted();
+    }
+
+private:
+    size_t k;                 // Número de pares a conservar
+    vector<TopKPairs> heaps;  // Un montículo por hilo
+};
+
+
+// Almacenamiento de la matriz de similitud. La matriz es simétrica y su diagonal no se usa, así
+// que sólo se guarda el triángulo superior (i < j). Cada fila i debe escribirla un solo hilo
+class SimilarityStorage {
+public:
+    virtual ~SimilarityStorage() = default;
+
+    // Número de documentos
+    virtual int size() const = 0;
+
+    // Guarda la similitud del par (i, j) con i < j
+    virtual void set(int i, int j, double value) = 0;
+
+    // Devuelve la similitud del par (i, j) en cualquier orden; 0 si no está almacenada
+    virtual double get(int i, int j) const = 0;
+
+    // Se llama una vez que terminó la escritura de todas las filas
+    virtual void finalize() {}
+
+    // Indica si un par con esta similitud se guardaría; la matriz empaquetada guarda todos
+    virtual bool keeps(double) const { return true; }
+
+    // Recorre los pares almacenados con i < j, en orden de fila y columna
+    virtual void forEachPair(const function<void(int, int, double)> &visit) const = 0;
+};
+
+// Triángulo superior empaquetado en un solo arreglo de float: n(n-1)/2 valores, sin duplicados
+// ni una fila en el heap por documento. Conveniente cuando n es pequeño
+class PackedTriangularStorage : public SimilarityStorage {
+public:
+    explicit PackedTriangularStorage(int n) : n(n), values(static_cast<size_t>(n) * max(n - 1, 0) / 2, 0.0f) {}
+
+    int size() const override { return n; }
+
+    void set(int i, int j, double value) override { values[offset(i, j)] = static_cast<float>(value); }
+
+    double get(int i, int j) const override {
+        if (i == j) return 0.0;
+        return values[offset(min(i, j), max(i, j))];
+    }
+
+    void forEachPair(const function<void(int, int, double)> &visit) const override {
+        size_t k = 0;
+        for (int i = 0; i < n; ++i) {
+            for (int j = i + 1; j < n; ++j) {
+                visit(i, j, values[k++]);
+            }
+        }
+    }
+
+private:
+    int n;                 // Número de documentos
+    vector<float> values;  // Filas del triángulo superior, una tras otra
+
+    // Posición del par (i, j), i < j: las filas anteriores ocupan i * (2n - i - 1) / 2 celdas
+    size_t offset(int i, int j) const {
+        return static_cast<size_t>(i) * (2 * static_cast<size_t>(n) - i - 1) / 2 + (j - i - 1);
+    }
+};
+
+// Matriz dispersa en formato CSR que sólo guarda los pares con similitud mayor que `threshold`.
+// Las filas se acumulan por separado mientras se escriben y `finalize` las compacta
+class SparseSimilarityStorage : public SimilarityStorage {
+public:
+    SparseSimilarityStorage(int n, double threshold) : n(n), threshold(threshold), pending(n) {}
+
+    int size() const override { return n; }
+
+    void set(int i, int j, double value) override {
+        if (value > threshold) {
+            pending[i].push_back({j, static_cast<float>(value)});
+        }
+    }
+
+    bool keeps(double value) const override { return value > threshold; }
+
+    void finalize() override {
+        rowStart.assign(n + 1, 0);
+        columns.clear();
+        values.clear();
+        for (int i = 0; i < n; ++i) {
+            sort(pending[i].begin(), pending[i].end(),
+                 [](const pair<int, float> &a, const pair<int, float> &b) { return a.first < b.first; });
+            for (const auto &entry : pending[i]) {
+                columns.push_back(entry.first);
+                values.push_back(entry.second);
+            }
+            rowStart[i + 1] = columns.size();
+            vector<pair<int, float>>().swap(pending[i]); // Liberamos la fila temporal
+        }
+    }
+
+    double get(int i, int j) const override {
+        if (i == j) return 0.0;
+        int row = min(i, j), column = max(i, j);
+        auto begin = columns.begin() + rowStart[row];
+        auto end = columns.begin() + rowStart[row + 1];
+        auto found = lower_bound(begin, end, column);
+        return (found != end && *found == column) ? values[found - columns.begin()] : 0.0;
+    }
+
+    void forEachPair(const function<void(int, int, double)> &visit) const override {
+        for (int i = 0; i < n; ++i) {
+            for (size_t k = rowStart[i]; k < rowStart[i + 1]; ++k) {
+                visit(i, columns[k], values[k]);
+            }
+        }
+    }
+
+private:
+    int n;                                     // Número de documentos
+    double threshold;                          // Sólo se guardan similitudes mayores que este valor
+    vector<vector<pair<int, float>>> pending;  // Filas en construcción
+    vector<size_t> rowStart;                   // Inicio de cada fila en `columns` y `values`
+    vector<int> columns;                       // Columna de cada valor almacenado
+    vector<float> values;                      // Similitudes almacenadas
+};
+
+// Función para decidir si un par con cota superior `bound` puede omitirse sin evaluarlo: ni la
+// matriz lo guardaría ni alcanza el umbral de los K mejores del hilo; cualquiera de los dos puede
+// ser nulo. En empate no se omite, porque el par aún podría ganar por sus índices
+bool canSkipPair(double bound, const SimilarityStorage *storage, const TopKCollector *topPairs, int worker) {
+    return (storage == nullptr || !storage->keeps(bound)) &&
+           (topPairs == nullptr || bound < topPairs->threshold(worker));
+}
+
+// Función para elegir el almacenamiento de la matriz: empaquetado mientras quepa en memoria
+// razonable y disperso a partir de `packedLimit` documentos
+unique_ptr<SimilarityStorage> makeSimilarityStorage(int n, const string &kind, double threshold,
+                                                    int packedLimit = 10000) {
+    if (kind == "packed" || (kind == "auto" && n <= packedLimit)) {
+        return unique_ptr<SimilarityStorage>(new PackedTriangularStorage(n));
+    }
+    return unique_ptr<SimilarityStorage>(new SparseSimilarityStorage(n, threshold));
+}
+
+// Función para estimar la caché de datos de la que dispone un hilo para los bloques de columnas:
+// la L2 del procesador si el sistema la informa, o 1 MiB
+size_t dataCacheBytes() {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (size > 0) return size;
+#endif
+    return size_t(1) << 20;
+}
+
+// Función para dividir las columnas [0, n) en bloques contiguos cuyos documentos ocupan a lo más
+// `budget` bytes (al menos un documento por bloque). Devuelve el inicio de cada bloque seguido de n
+template <typename CharT>
+vector<int> columnBlocks(const vector<basic_string_view<CharT>> &documents, size_t budget) {
+    int n = documents.size();
+    vector<int> starts;
+    size_t used = 0;                           // Bytes del bloque en construcción
+    for (int j = 0; j < n; ++j) {
+        size_t bytes = documents[j].size() * sizeof(CharT);
+        if (starts.empty() || used + bytes > budget) {
+            starts.push_back(j);
+            used = 0;
+        }
+        used += bytes;
+    }
+    starts.push_back(n);
+    return starts;
+}
+
+// Control de una evaluación lanzada desde la API de biblioteca: cancelación y avance. Las tareas
+// consultan la cancelación antes de cada par con una lectura relajada y avisan al terminar
+class ScoringControl {
+public:
+    atomic<bool> cancelled{false};               // Se pidió detener la evaluación
+    function<void(uint64_t, uint64_t)> progress; // (tareas terminadas, total); puede estar vacío
+
+    bool stopped() const { return cancelled.load(memory_order_relaxed); }
+
+    // Reinicia el avance para una etapa de `tasks` tareas
+    void start(uint64_t tasks) {
+        lock_guard<mutex> lock(progressMutex);
+        completed = 0;
+        total = tasks;
+    }
+
+    // Marca una tarea como terminada; el callback se llama de uno en uno aunque haya varios hilos
+    void taskDone() {
+        lock_guard<mutex> lock(progressMutex);
+        ++completed;
+        if (progress) progress(completed, total);
+    }
+
+private:
+    mutex progressMutex;
+    uint64_t completed = 0;                      // Tareas terminadas de la etapa
+    uint64_t total = 0;                          // Tareas de la etapa
+};
+
+// Función para generar una matriz de similitud para un vector de documentos. El triángulo
+// superior se recorre por bloques: cada tarea del planificador toma `blockRows` filas
+// consecutivas, prepara sus autómatas una sola vez y recorre sus columnas por bloques de
+// documentos que caben juntos en `blockCache` bytes de caché (0 = la mitad de la L2), de modo que
+// cada bloque de columnas se lee de memoria una vez por bloque de filas y no una vez por fila.
+// Con blockRows = 1 es el recorrido por filas. Como cada celda se calcula de forma independiente,
+// el resultado es el mismo con cualquier número de hilos y cualquier tamaño de bloque. Si se da un
+// índice de shingles, sólo se evalúan los pares que comparten al menos `minShared` de ellos. Cada
+// valor se entrega conforme se calcula a `similarityMatrix` (empaquetada o dispersa) y/o a
+// `topPairs`; cualquiera de los dos puede ser nulo. Con `control`, cada bloque de filas informa su
+// avance y, si se cancela, los pares restantes no se evalúan
+template <typename CharT>
+void generateSimilarityMatrix(const vector<basic_string_view<CharT>> &documents, int minLength,
+                              SimilarityStorage *similarityMatrix,
+                              TopKCollector *topPairs, SubstringBackend backend = SubstringBackend::SuffixAutomaton,
+                              int threadCount = 1, const ShingleIndex *index = nullptr, int minShared = 1,
+                              bool verifySpans = false, SimilarityMode mode = SimilarityMode::Mass,
+                              int blockRows = 1, size_t blockCache = 0, ScoringControl *control = nullptr) {
+    int n = documents.size();                 // Número de documentos
+    blockRows = max(1, blockRows);
+    int taskCount = (n + blockRows - 1) / blockRows;
+    if (control != nullptr) {
+        control->start(taskCount);
+    }
+    vector<int> columns = columnBlocks(documents, blockCache > 0 ? blockCache : dataCacheBytes() / 2);
+    WorkStealingScheduler scheduler(threadCount);
+    // Memoria temporal por hilo: una por fila del bloque; los contadores del índice son los de la primera
+    vector<vector<PairScratch<CharT>>> scratch(scheduler.threadCount(), vector<PairScratch<CharT>>(blockRows));
+    vector<vector<size_t>> cursors(scheduler.threadCount(), vector<size_t>(blockRows)); // Siguiente candidato de cada fila
+    vector<vector<char>> prepared(scheduler.threadCount(), vector<char>(blockRows)); // Filas con su autómata listo
+    // Con el índice, los pares cuya cota no alcanza el umbral de los K mejores (que sube durante la
+    // ejecución) ni el de la matriz se omiten sin leerlos
+    bool bounded = index != nullptr && mode == SimilarityMode::Coverage;
+
+    // Calculamos la similitud para cada par de documentos
+    scheduler.run(taskCount, [&](int task, int worker) {
+        if (control != nullptr && control->stopped()) {
+            return;                            // Evaluación cancelada
+        }
+        vector<PairScratch<CharT>> &rows = scratch[worker];
+        vector<size_t> &cursor = cursors[worker];
+        int first = task * blockRows;          // Primera fila del bloque
+        int count = min(blockRows, n - first); // Filas del bloque
+        uint64_t candidates = 0;               // Pares candidatos del bloque
+        uint64_t skipped = 0;                  // Candidatos descartados por su cota
+        for (int r = 0; r < count; ++r) {
+            int i = first + r;
+            PairScratch<CharT> &local = rows[r];
+            local.candidates.clear();
+            cursor[r] = 0;
+            prepared[worker][r] = 0;
+            if (index != nullptr) {
+                rows[0].counts.resize(n, 0);
+                index->candidates(i, minShared, rows[0].counts, rows[0].touched, local.candidates, -1,
+                                  bounded ? &local.shared : nullptr); // Columnas con shingles en común
+            } else {
+                for (int j = i + 1; j < n; ++j) {
+                    local.candidates.push_back(j);
+                }
+            }
+            candidates += local.candidates.size();
+            countStat(runStats().pairsPruned, n - i - 1 - local.candidates.size());
+        }
+        if (candidates == 0) {
+            if (control != nullptr) control->taskDone();
+            return;                            // Ningún par del bloque puede ser similar
+        }
+        // Cada bloque de columnas se evalúa contra todas las filas del bloque antes de pasar al siguiente
+        int block = upper_bound(columns.begin(), columns.end(), first + 1) - columns.begin() - 1;
+        for (; block + 1 < static_cast<int>(columns.size()); ++block) {
+            int end = columns[block + 1];
+            for (int r = 0; r < count; ++r) {
+                int i = first + r;
+                PairScratch<CharT> &local = rows[r];
+                for (; cursor[r] < local.candidates.size() && local.candidates[cursor[r]] < end; ++cursor[r]) {
+                    int j = local.candidates[cursor[r]];
+                    if (control != nullptr && control->stopped()) {
+                        return;                // Cancelada a mitad del bloque
+                    }
+                    if (bounded) {
+                        double bound = similarityUpperBound(mode, documents[i].size(), documents[j].size(),
+                                                            index->shingleCount(i), index->shingleCount(j),
+                                                            local.shared[cursor[r]], minLength);
+                        if (canSkipPair(bound, similarityMatrix, topPairs, worker)) {
+                            skipped++;
+                            continue;
+                        }
+                    }
+                    double similarity;
+                    if (backend == SubstringBackend::SuffixAutomaton) {
+                        if (!prepared[worker][r]) {
+                            prepareRow(documents[i], minLength, mode, local); // Una sola vez por fila
+                            prepared[worker][r] = 1;
+                        }
+                        similarity = rowPairSimilarity(documents[i], documents[j], minLength, mode, local);
+                    } else {
+                        similarity = similarityMetric(documents[i], documents[j], minLength, backend, verifySpans,
+                                                      mode); // Calculamos similitud
+                    }
+                    if (similarityMatrix != nullptr) {
+                        similarityMatrix->set(i, j, similarity); // Sólo se guarda el triángulo superior
+                    }
+                    if (topPairs != nullptr) {
+                        topPairs->push(worker, {i, j, similarity}); // Montículo propio del hilo
+                    }
+                }
+            }
+        }
+        countStat(runStats().pairsScored, candidates - skipped);
+        countStat(runStats().pairsPruned, skipped);
+        if (control != nullptr) control->taskDone();
+    });
+    if (similarityMatrix != nullptr) {
+        similarityMatrix->finalize();         // Compactamos la matriz si es dispersa
+    }
+}
+
+// Función para el modo incremental: evalúa sólo los pares en los que participa algún documento
+// nuevo. Los documentos [0, archiveCount) son el archivo ya indexado y [archiveCount, n) son las
+// entregas nuevas; se calculan los pares nuevo x archivo y nuevo x nuevo, O(nuevos * n) en lugar
+// de O(n^2), y con el índice de shingles sólo los que comparten algún shingle. `backend` elige el
+// motor de cada par como en generateSimilarityMatrix
+template <typename CharT>
+void scoreQueryPairs(const vector<basic_string_view<CharT>> &documents, int archiveCount, int minLength,
+                     TopKCollector &topPairs,
+                     int threadCount = 1, const ShingleIndex *index = nullptr, int minShared = 1,
+                     SimilarityMode mode = SimilarityMode::Mass,
+                     SubstringBackend backend = SubstringBackend::SuffixAutomaton, bool verifySpans = false) {
+    int n = documents.size();
+    bool bounded = index != nullptr && mode == SimilarityMode::Coverage; // Omitir pares por su cota
+    WorkStealingScheduler scheduler(threadCount);
+    vector<PairScratch<CharT>> scratch(scheduler.threadCount());
+    scheduler.run(n - archiveCount, [&](int task, int worker) {
+        PairScratch<CharT> &local = scratch[worker];
+        int q = archiveCount + task;           // Documento nuevo de esta fila
+        local.candidates.clear();
+        if (index != nullptr) {
+            local.counts.resize(n, 0);
+            index->candidates(q, minShared, local.counts, local.touched, local.candidates, 0,
+                              bounded ? &local.shared : nullptr);
+        } else {
+            for (int j = 0; j < n; ++j) {
+                if (j != q) local.candidates.push_back(j);
+            }
+        }
+        bool built = false;
+        uint64_t scored = 0;                   // Pares de la fila evaluados
+        for (size_t c = 0; c < local.candidates.size(); ++c) {
+            int j = local.candidates[c];
+            if (j >= archiveCount && j < q) {
+                continue;                      // El par nuevo x nuevo lo evalúa la fila de j
+            }
+            if (bounded && canSkipPair(similarityUpperBound(mode, documents[q].size(), documents[j].size(),
+                                                            index->shingleCount(q), index->shingleCount(j),
+                                                            local.shared[c], minLength),
+                                       nullptr, &topPairs, worker)) {
+                continue;                      // Su cota no alcanza a los K mejores del hilo
+            }
+            scored++;
+            double similarity = backendPairSimilarity(documents[q], documents[j], minLength, mode, backend,
+                                                      verifySpans, local, built); // Un autómata por documento nuevo
+            topPairs.push(worker, {min(q, j), max(q, j), similarity});
+        }
+        countStat(runStats().pairsScored, scored);
+        countStat(runStats().pairsPruned, archiveCount + (n - q - 1) - scored); // Archivo y nuevos posteriores
+    });
+}
+
+// Función para el modo distribuido: evalúa los pares de un bloque de la matriz. Los documentos
+// [0, split) son las filas del bloque y [split, n) sus columnas; si split == n el bloque está en
+// la diagonal y se evalúan los pares i < j entre sus propios documentos. Los K mejores pares van a
+// `topPairs` y, si `above` no es nulo, también se devuelven todos los que superan `threshold`.
+// `backend` elige el motor de cada par como en generateSimilarityMatrix
+template <typename CharT>
+void scoreTilePairs(const vector<basic_string_view<CharT>> &documents, int split, int minLength,
+                    TopKCollector &topPairs, vector<ScoredPair> *above, double threshold,
+                    int threadCount = 1, const ShingleIndex *index = nullptr, int minShared = 1,
+                    SimilarityMode mode = SimilarityMode::Mass,
+                    SubstringBackend backend = SubstringBackend::SuffixAutomaton, bool verifySpans = false) {
+    int n = documents.size();
+    bool diagonal = split == n;                // Bloque de la diagonal: filas y columnas coinciden
+    bool bounded = index != nullptr && mode == SimilarityMode::Coverage; // Omitir pares por su cota
+    WorkStealingScheduler scheduler(threadCount);
+    vector<PairScratch<CharT>> scratch(scheduler.threadCount());
+    vector<vector<ScoredPair>> kept(scheduler.threadCount()); // Pares sobre el umbral, por hilo
+    scheduler.run(split, [&](int i, int worker) {
+        PairScratch<CharT> &local = scratch[worker];
+        int firstColumn = diagonal ? i + 1 : split;
+        local.candidates.clear();
+        if (index != nullptr) {
+            local.counts.resize(n, 0);
+            index->candidates(i, minShared, local.counts, local.touched, local.candidates, firstColumn,
+                              bounded ? &local.shared : nullptr);
+        } else {
+            for (int j = firstColumn; j < n; ++j) {
+                local.candidates.push_back(j);
+            }
+        }
+        bool built = false;
+        uint64_t scored = 0;                   // Pares de la fila evaluados
+        for (size_t c = 0; c < local.candidates.size(); ++c) {
+            int j = local.candidates[c];
+            if (bounded) {
+                double bound = similarityUpperBound(mode, documents[i].size(), documents[j].size(),
+                                                    index->shingleCount(i), index->shingleCount(j), local.shared[c],
+                                                    minLength);
+                if (canSkipPair(bound, nullptr, &topPairs, worker) && (above == nullptr || bound <= threshold)) {
+                    continue;                  // Ni entra en los K mejores ni supera el umbral
+                }
+            }
+            scored++;
+            double similarity = backendPairSimilarity(documents[i], documents[j], minLength, mode, backend,
+                                                      verifySpans, local, built);
+            topPairs.push(worker, {i, j, similarity});
+            if (above != nullptr && similarity > threshold) {
+                kept[worker].push_back({i, j, similarity});
+            }
+        }
+        countStat(runStats().pairsScored, scored);
+        countStat(runStats().pairsPruned, n - firstColumn - scored);
+    });
+    if (above != nullptr) {
+        for (auto &pairs : kept) {
+            above->insert(above->end(), pairs.begin(), pairs.end());
+        }
+    }
+}
+
+// Mejores pares guardados de una ejecución (--top-store). Los pares usan índices de `paths`, que sólo
+// contiene los documentos que aparecen en algún par, porque los índices del corpus cambian entre
+// ejecuciones; el hash del contenido de cada documento detecta los que cambiaron desde entonces
+struct StoredTopPairs {
+    uint32_t minLength = 0;            // Longitud mínima de las subcadenas comunes
+    uint32_t similarity = 0;           // Medida de similitud (SimilarityMode)
+    uint64_t normalization = 0;        // Normalización de los tokens (0 = bytes)
+    uint64_t topCount = 0;             // Mejores pares que se pidieron (--top)
+    vector<string> paths;              // Rutas de los documentos referenciados
+    vector<uint64_t> hashes;           // contentHash de cada documento de `paths`
+    vector<ScoredPair> pairs;          // Pares guardados, del más al menos similar
+};
+
+// Función para leer los mejores pares guardados. Formato binario: "PDTK", versión 2, minLength,
+// similarity (u32), normalization, topCount (u64), número de documentos (u64) y, por documento, su
+// ruta (longitud u32 + bytes) y su contentHash (u64), y número de pares (u64) con first, second
+// (u32) y similarity (f64). Devuelve false si el archivo no se puede leer o está truncado
+bool loadStoredTopPairs(const string &path, StoredTopPairs &stored) {
+    ifstream in(path, ios::binary);
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t count = 0;
+    auto read = [&](void *out, size_t bytes) { return static_cast<bool>(in.read(static_cast<char *>(out), bytes)); };
+    if (!read(magic, 4) || memcmp(magic, "PDTK", 4) != 0 || !read(&version, 4) || version != 2 ||
+        !read(&stored.minLength, 4) || !read(&stored.similarity, 4) || !read(&stored.normalization, 8) ||
+        !read(&stored.topCount, 8) || !read(&count, 8)) {
+        return false;
+    }
+    stored.paths.assign(count, string());
+    stored.hashes.assign(count, 0);
+    for (uint64_t d = 0; d < count; ++d) {
+        uint32_t length;
+        if (!read(&length, 4)) return false;
+        stored.paths[d].resize(length);
+        if (!read(&stored.paths[d][0], length) || !read(&stored.hashes[d], 8)) return false;
+    }
+    if (!read(&count, 8)) return false;
+    stored.pairs.clear();
+    for (uint64_t p = 0; p < count; ++p) {
+        uint32_t first, second;
+        double similarity;
+        if (!read(&first, 4) || !read(&second, 4) || !read(&similarity, 8) || first == second ||
+            max(first, second) >= stored.paths.size()) {
+            return false;
+        }
+        stored.pairs.push_back({static_cast<int>(first), static_cast<int>(second), similarity});
+    }
+    return true;
+}
+
+// Función para guardar los mejores pares con los parámetros de la ejecución y la ruta y el hash de
+// contenido de sus documentos; devuelve false si falla
+bool saveStoredTopPairs(const string &path, const vector<ScoredPair> &pairs, const vector<string> &paths,
+                        const vector<uint64_t> &hashes, int minLength, SimilarityMode mode, uint64_t normalization,
+                        int topCount) {
+    vector<int> local(paths.size(), -1);      // Índice de cada documento del corpus en el archivo
+    vector<int> referenced;
+    for (const auto &pair : pairs) {
+        for (int d : {pair.first, pair.second}) {
+            if (local[d] < 0) {
+                local[d] = referenced.size();
+                referenced.push_back(d);
+            }
+        }
+    }
+    ofstream out(path, ios::binary | ios::trunc);
+    auto write = [&](const void *data, size_t bytes) { out.write(static_cast<const char *>(data), bytes); };
+    uint32_t version = 2, length = minLength, similarity = static_cast<uint32_t>(mode);
+    uint64_t top = topCount, count = referenced.size();
+    out.write("PDTK", 4);
+    write(&version, 4);
+    write(&length, 4);
+    write(&similarity, 4);
+    write(&normalization, 8);
+    write(&top, 8);
+    write(&count, 8);
+    for (int d : referenced) {
+        uint32_t size = paths[d].size();
+        write(&size, 4);
+        write(paths[d].data(), size);
+        write(&hashes[d], 8);
+    }
+    count = pairs.size();
+    write(&count, 8);
+    for (const auto &pair : pairs) {
+        uint32_t first = local[pair.first], second = local[pair.second];
+        write(&first, 4);
+        write(&second, 4);
+        write(&pair.similarity, 8);
+    }
+    return static_cast<bool>(out);
+}
+
+// Resultado parcial de un nodo en el modo distribuido (--shard i/N). Los pares usan índices de
+// `paths`, que sólo contiene los documentos que aparecen en algún par; al combinar los parciales
+// los documentos se identifican por su ruta
+struct ShardResult {
+    uint32_t shard = 0;                // Fragmento que evaluó este nodo (de 0 a shardCount - 1)
+    uint32_t shardCount = 1;           // Número total de fragmentos
+    uint32_t minLength = 0;            // Longitud mínima de las subcadenas comunes
+    uint32_t similarity = 0;           // Medida de similitud (SimilarityMode)
+    uint32_t backend = 0;              // Motor de subcadenas comunes (SubstringBackend)
+    uint64_t normalization = 0;        // Normalización de los tokens (0 = bytes)
+    uint64_t topCount = 0;             // Mejores pares que guardó el fragmento (--top)
+    double threshold = 0.0;            // Umbral de los pares de `above` (--threshold)
+    vector<string> paths;              // Rutas de los documentos referenciados
+    vector<ScoredPair> top;            // Mejores pares del fragmento, del mejor al peor
+    vector<ScoredPair> above;          // Pares con similitud mayor que --threshold (con --export-all)
+};
+
+// Función para guardar un resultado parcial. Formato binario "PDSH", versión, fragmento, número de
+// fragmentos, longitud mínima, medida, motor, normalización, --top, --threshold, las rutas precedidas por su longitud y las dos
+// listas de pares (primero, segundo, similitud), cada una precedida por su tamaño
+bool saveShardResult(const string &path, const ShardResult &result) {
+    ofstream out(path, ios::binary | ios::trunc);
+    uint32_t version = 3;
+    out.write("PDSH", 4);
+    for (uint32_t field : {version, result.shard, result.shardCount, result.minLength, result.similarity,
+                           result.backend}) {
+        out.write(reinterpret_cast<const char *>(&field), 4);
+    }
+    out.write(reinterpret_cast<const char *>(&result.normalization), 8);
+    out.write(reinterpret_cast<const char *>(&result.topCount), 8);
+    out.write(reinterpret_cast<const char *>(&result.threshold), 8);
+    uint64_t count = result.paths.size();
+    out.write(reinterpret_cast<const char *>(&count), 8);
+    for (const auto &document : result.paths) {
+        uint32_t length = document.size();
+        out.write(reinterpret_cast<const char *>(&length), 4);
+        out.write(document.data(), length);
+    }
+    for (const vector<ScoredPair> *pairs : {&result.top, &result.above}) {
+        count = pairs->size();
+        out.write(reinterpret_cast<const char *>(&count), 8);
+        for (const auto &pair : *pairs) {
+            uint32_t first = pair.first, second = pair.second;
+            out.write(reinterpret_cast<const char *>(&first), 4);
+            out.write(reinterpret_cast<const char *>(&second), 4);
+            out.write(reinterpret_cast<const char *>(&pair.similarity), 8);
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+// Función para leer un resultado parcial; devuelve false si no existe, está truncado o no es válido
+bool loadShardResult(const string &path, ShardResult &result) {
+    ifstream in(path, ios::binary);
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t count = 0;
+    auto read = [&](void *out, size_t bytes) { return static_cast<bool>(in.read(static_cast<char *>(out), bytes)); };
+    if (!read(magic, 4) || memcmp(magic, "PDSH", 4) != 0 || !read(&version, 4) || version != 3 ||
+        !read(&result.shard, 4) || !read(&result.shardCount, 4) || !read(&result.minLength, 4) ||
+        !read(&result.similarity, 4) || !read(&result.backend, 4) || !read(&result.normalization, 8) ||
+        !read(&result.topCount, 8) || !read(&result.threshold, 8) || !read(&count, 8) ||
+        result.shard >= result.shardCount) {
+        return false;
+    }
+    result.paths.assign(count, string());
+    for (auto &document : result.paths) {
+        uint32_t length;
+        if (!read(&length, 4)) return false;
+        document.resize(length);
+        if (!read(&document[0], length)) return false;
+    }
+    for (vector<ScoredPair> *pairs : {&result.top, &result.above}) {
+        if (!read(&count, 8)) return false;
+        pairs->clear();
+        for (uint64_t p = 0; p < count; ++p) {
+            uint32_t first, second;
+            double similarity;
+            if (!read(&first, 4) || !read(&second, 4) || !read(&similarity, 8) || first >= second ||
+                second >= result.paths.size()) {
+                return false;
+            }
+            pairs->push_back({static_cast<int>(first), static_cast<int>(second), similarity});
+        }
+    }
+    return true;
+}
+
+// Función para calcular la firma MinHash clásica de un conjunto de shingles: para cada una de
+// las `functions` funciones hash se guarda el mínimo. Se usa para agrupar documentos con LSH
+vector<uint64_t> minHashSignature(const vector<uint64_t> &shingles, int functions) {
+    vector<uint64_t> signature(functions, UINT64_MAX);
+    for (int f = 0; f < functions; ++f) {
+        uint64_t seed = mixHash(0x9e3779b97f4a7c15ULL * (f + 1)); // Semilla distinta por función
+        uint64_t best = UINT64_MAX;
+        for (uint64_t hash : shingles) {
+            best = min(best, mixHash(hash ^ seed));
+        }
+        signature[f] = best;
+    }
+    return signature;
+}
+
+// Función para obtener los pares candidatos por LSH: las firmas se dividen en `bands` bandas de
+// `rows` filas y dos documentos son candidatos si coinciden en todas las filas de alguna banda.
+// Un par con similitud de Jaccard s es candidato con probabilidad 1 - (1 - s^rows)^bands.
+// Devuelve los pares (i, j) con i < j codificados como (i << 32) | j, ordenados y sin repetir
+vector<uint64_t> lshCandidatePairs(const vector<vector<uint64_t>> &signatures, int bands, int rows) {
+    vector<uint64_t> pairs;
+    vector<pair<uint64_t, int>> buckets;       // Pares (hash de la banda, documento)
+    for (int b = 0; b < bands; ++b) {
+        buckets.clear();
+        for (int d = 0; d < static_cast<int>(signatures.size()); ++d) {
+            if (signatures[d].empty() || signatures[d][0] == UINT64_MAX) {
+                continue;                      // Documento sin shingles: no hay nada que agrupar
+            }
+            uint64_t key = mixHash(b + 1);
+            for (int r = 0; r < rows; ++r) {
+                key = mixHash(key ^ signatures[d][b * rows + r]);
+            }
+            buckets.push_back({key, d});
+        }
+        sort(buckets.begin(), buckets.end());  // Los documentos de una misma cubeta quedan juntos
+        for (size_t start = 0; start < buckets.size();) {
+            size_t end = start;
+            while (end < buckets.size() && buckets[end].first == buckets[start].first) end++;
+            for (size_t x = start; x < end; ++x) {
+                for (size_t y = x + 1; y < end; ++y) {
+                    pairs.push_back((static_cast<uint64_t>(buckets[x].second) << 32) | buckets[y].second);
+                }
+            }
+            start = end;
+        }
+    }
+    sort(pairs.begin(), pairs.end());
+    pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+    return pairs;
+}
+
+// Función para evaluar de forma exacta una lista de pares candidatos (ordenada por primer índice)
+// y conservar los `topCount` mejores. Cada fila de candidatos es una tarea del planificador; los
+// pares evaluados se suman a `scored` (por defecto, a los pares evaluados de --stats). `backend`
+// elige el motor de cada par como en generateSimilarityMatrix
+template <typename CharT>
+vector<ScoredPair> scoreCandidatePairs(const vector<basic_string_view<CharT>> &documents, const vector<uint64_t> &pairs,
+                                       int minLength, size_t topCount, int threadCount,
+                                       SimilarityMode mode = SimilarityMode::Mass,
+                                       SubstringBackend backend = SubstringBackend::SuffixAutomaton,
+                                       bool verifySpans = false, atomic<uint64_t> &scored = runStats().pairsScored) {
+    vector<size_t> rowStart;                   // Inicio de cada fila dentro de `pairs`
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        if (p == 0 || (pairs[p] >> 32) != (pairs[p - 1] >> 32)) rowStart.push_back(p);
+    }
+    rowStart.push_back(pairs.size());
+
+    WorkStealingScheduler scheduler(threadCount);
+    vector<PairScratch<CharT>> scratch(scheduler.threadCount());
+    TopKCollector best(topCount, scheduler.threadCount());
+    scheduler.run(static_cast<int>(rowStart.size()) - 1, [&](int row, int worker) {
+        PairScratch<CharT> &local = scratch[worker];
+        int i = pairs[rowStart[row]] >> 32;
+        bool prepared = false;                 // Un autómata por fila de candidatos
+        countStat(scored, rowStart[row + 1] - rowStart[row]);
+        for (size_t p = rowStart[row]; p < rowStart[row + 1]; ++p) {
+            int j = static_cast<uint32_t>(pairs[p]);
+            best.push(worker, {i, j, backendPairSimilarity(documents[i], documents[j], minLength, mode, backend,
+                                                           verifySpans, local, prepared)});
+        }
+    });
+    return best.result();
+}
+
+// Función para estimar el recall del modo LSH: sobre una muestra de documentos se calculan de forma
+// exacta los `topCount` mejores pares y se mide qué fracción de ellos aparece entre los candidatos
+template <typename CharT>
+double estimateLshRecall(const vector<basic_string_view<CharT>> &documents, const vector<uint64_t> &candidates,
+                         int minLength, size_t topCount, int sampleSize, int threadCount,
+                         SimilarityMode mode = SimilarityMode::Mass,
+                         SubstringBackend backend = SubstringBackend::SuffixAutomaton, bool verifySpans = false) {
+    int n = documents.size();
+    vector<int> sample;                        // Documentos de la muestra, espaciados uniformemente
+    for (int s = 0; s < min(sampleSize, n); ++s) {
+        sample.push_back(static_cast<int>(static_cast<long long>(s) * n / min(sampleSize, n)));
+    }
+    vector<uint64_t> samplePairs;              // Todos los pares de la muestra
+    for (size_t x = 0; x < sample.size(); ++x) {
+        for (size_t y = x + 1; y < sample.size(); ++y) {
+            samplePairs.push_back((static_cast<uint64_t>(sample[x]) << 32) | sample[y]);
+        }
+    }
+    int found = 0, relevant = 0;
+    for (const auto &pair : scoreCandidatePairs(documents, samplePairs, minLength, topCount, threadCount, mode,
+                                                backend, verifySpans, runStats().samplePairsScored)) {
+        if (pair.similarity <= 0.0) continue;  // Los pares sin coincidencias no cuentan
+        relevant++;
+        uint64_t key = (static_cast<uint64_t>(pair.first) << 32) | pair.second;
+        found += binary_search(candidates.begin(), candidates.end(), key);
+    }
+    return relevant == 0 ? 1.0 : static_cast<double>(found) / relevant;
+}
+
+// Función para fusionar los intervalos [inicio, fin) solapados o contiguos; se ordenan en el lugar
+void mergeIntervals(vector<pair<int, int>> &intervals) {
+    sort(intervals.begin(), intervals.end());
+    size_t merged = 0;
+    for (const auto &interval : intervals) {
+        if (merged > 0 && interval.first <= intervals[merged - 1].second) {
+            intervals[merged - 1].second = max(intervals[merged - 1].second, interval.second);
+        } else {
+            intervals[merged++] = interval;
+        }
+    }
+    intervals.resize(merged);
+}
+
+// Función para copiar `text` en `out` envolviendo en <mark> los intervalos ya fusionados
+void appendHighlighted(string &out, string_view text, const vector<pair<int, int>> &intervals) {
+    size_t written = 0;                    // Caracteres de `text` ya copiados
+    for (const auto &interval : intervals) {
+        out.append(text.substr(written, interval.first - written));
+        out.append("<mark>");
+        out.append(text.substr(interval.first, interval.second - interval.first));
+        out.append("</mark>");
+        written = interval.second;
+    }
+    out.append(text.substr(written));
+}
+
+// Función para resaltar en una sola pasada las secciones comunes de ambos textos. Se marca cada
+// carácter que pertenece a alguna subcadena común de longitud >= minLength: las coincidencias
+// maximales de cada texto contra el autómata del otro cubren exactamente esas posiciones, y sus
+// intervalos se fusionan para que las etiquetas nunca se aniden. El resultado se agrega a `out`.
+// `matches2` puede traer ya calculadas las coincidencias maximales de str2 contra str1.
+// Complejidad O(m + n + S log S). Con --backend dp las mismas posiciones salen de las estadísticas de
+// coincidencia de la tabla DP (dynamicMatchingStatistics), en O(m * n), y se ignora `matches2`
+void highlightSimilarities(string_view str1, string_view str2, int minLength, string &out,
+                           const vector<MatchSpan> *matches2 = nullptr,
+                           SubstringBackend backend = SubstringBackend::SuffixAutomaton) {
+    vector<pair<int, int>> intervals1, intervals2; // Intervalos [inicio, fin) a resaltar
+    if (backend == SubstringBackend::DynamicProgramming) {
+        vector<int> longest1(str1.size(), 0), longest2(str2.size(), 0);
+        dynamicMatchingStatistics(str1, str2, longest1, longest2);
+        for (auto [longest, intervals] : {make_pair(&longest1, &intervals1), make_pair(&longest2, &intervals2)}) {
+            for (int e = 0; e < static_cast<int>(longest->size()); ++e) {
+                int length = (*longest)[e];
+                if (length >= minLength) intervals->push_back({e + 1 - length, e + 1});
+            }
+        }
+    } else {
+        for (const auto &match : findMaximalMatches(str1, str2, minLength)) {
+            intervals1.push_back({match.pos1, match.pos1 + match.length});
+        }
+        vector<MatchSpan> computed;
+        if (matches2 == nullptr) {
+            computed = findMaximalMatches(str2, str1, minLength);
+            matches2 = &computed;
+        }
+        for (const auto &match : *matches2) {
+            intervals2.push_back({match.pos1, match.pos1 + match.length});
+        }
+    }
+    mergeIntervals(intervals1);
+    mergeIntervals(intervals2);
+
+    // Reservamos de una vez el tamaño final: textos, etiquetas <mark></mark> y encabezados
+    static const string_view header1 = "<h3>Texto 1:</h3><p>", header2 = "</p><h3>Texto 2:</h3><p>", footer = "</p>";
+    out.reserve(out.size() + header1.size() + header2.size() + footer.size() + str1.size() + str2.size() +
+                13 * (intervals1.size() + intervals2.size()));
+    out.append(header1);
+    appendHighlighted(out, str1, intervals1);
+    out.append(header2);
+    appendHighlighted(out, str2, intervals2);
+    out.append(footer);
+}
+
+// Salida con un búfer grande: el texto se acumula en memoria y se escribe al archivo en bloques de
+// al menos `capacity` bytes, en lugar de una escritura pequeña por cada fragmento
+class BufferedSink {
+public:
+    explicit BufferedSink(size_t capacity = 1 << 22) : capacity(capacity) {}
+    ~BufferedSink() { close(); }
+
+    bool open(const string &path) {
+        file.open(path, ios::binary | ios::trunc);
+        buffer.reserve(capacity);
+        return static_cast<bool>(file);
+    }
+
+    // Búfer al que se agrega el texto directamente; hay que llamar a commit() después
+    string &data() { return buffer; }
+
+    void commit() {
+        if (buffer.size() >= capacity) flush();
+    }
+
+    BufferedSink &operator<<(string_view text) {
+        buffer.append(text);
+        commit();
+        return *this;
+    }
+
+    BufferedSink &operator<<(long long value) {
+        char digits[24];
+        buffer.append(digits, snprintf(digits, sizeof(digits), "%lld", value));
+        commit();
+        return *this;
+    }
+
+    // Agrega un número con `precision` decimales, como `fixed << setprecision(precision)`
+    void appendFixed(double value, int precision) {
+        char digits[64];
+        buffer.append(digits, snprintf(digits, sizeof(digits), "%.*f", precision, value));
+        commit();
+    }
+
+    void flush() {
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    // Escribe lo pendiente y cierra el archivo; devuelve false si alguna escritura falló
+    bool close() {
+        if (!file.is_open()) return true;
+        flush();
+        file.close();
+        return !file.fail();
+    }
+
+private:
+    size_t capacity;                           // Tamaño a partir del cual se vacía el búfer
+    string buffer;                             // Texto pendiente de escribir
+    ofstream file;                             // Archivo de salida
+};
+
+// Reporte HTML que se escribe en flujo: cada par se emite en cuanto se calculan sus métricas y su
+// texto resaltado se genera sólo en ese momento. Con `detailDirectory` los textos resaltados, la
+// parte pesada del reporte, van a un archivo por par y la página principal sólo los carga al abrirlos
+class HtmlReportWriter {
+public:
+    bool open(const string &path, int pairCount, const string &detailDirectory = "") {
+        details = detailDirectory;
+        if (!details.empty()) {
+            error_code error;
+            fs::create_directories(details, error);
+            if (error) return false;
+        }
+        if (!index.open(path)) return false;
+        index << "<html><head><title>Textos Más Similares</title></head><body>"; // Encabezado HTML
+        index << "<h1>" << static_cast<long long>(pairCount) << " Pares de Textos Más Similares</h1>";
+        return true;
+    }
+
+    // Escribe el par `rank` (desde 1). Si `editLimit` >= 0 y la distancia lo supera, sólo se indica la cota.
+    // `matches2` son las coincidencias maximales de str2 contra str1 si ya se calcularon; `backend` elige
+    // cómo se obtienen las secciones resaltadas
+    bool writePair(int rank, double similarity, double editDist, int editLimit, double containment,
+                   string_view str1, string_view str2, int minLength, const vector<MatchSpan> *matches2 = nullptr,
+                   SubstringBackend backend = SubstringBackend::SuffixAutomaton) {
+        index << "<h2>Par " << static_cast<long long>(rank) << " (Similitud: ";
+        index.appendFixed(similarity, 2);
+        index << ", Distancia de Edición: ";
+        if (editLimit >= 0 && editDist > editLimit) {
+            index << "&gt; " << static_cast<long long>(editLimit); // El par está lejos: no necesitamos el valor exacto
+        } else {
+            index.appendFixed(editDist, 2);
+        }
+        index << ", Contención de Broder: ";
+        index.appendFixed(containment, 2);
+        index << ")</h2>";
+        if (details.empty()) {
+            highlightSimilarities(str1, str2, minLength, index.data(), matches2, backend); // Resaltamos las secciones comunes
+            index.commit();
+            return true;
+        }
+        string name = "par_" + to_string(rank) + ".html";
+        BufferedSink detail;
+        if (!detail.open((fs::path(details) / name).string())) return false;
+        detail << "<html><body>";
+        highlightSimilarities(str1, str2, minLength, detail.data(), matches2, backend);
+        detail << "</body></html>";
+        string link = (fs::path(details) / name).generic_string();
+        index << "<p><a href=\"" << link << "\">Abrir textos resaltados</a></p><details><summary>Ver aquí</summary>"
+              << "<iframe src=\"" << link << "\" loading=\"lazy\" style=\"width:100%;height:60vh\"></iframe></details>";
+        return detail.close();
+    }
+
+    bool close() {
+        index << "</body></html>";             // Cierre del HTML
+        return index.close();
+    }
+
+private:
+    BufferedSink index;                        // Página principal del reporte
+    string details;                            // Carpeta de los archivos por par (vacío = en línea)
+};
+
+// Función para comprobar si un nombre de archivo coincide con un patrón con comodines * y ?
+bool matchesGlob(const string &name, const string &pattern) {
+    size_t n = 0, p = 0;
+    size_t starPattern = string::npos, starName = 0; // Última posición de * para retroceder
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            n++;
+            p++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            starPattern = p++;
+            starName = n;
+        } else if (starPattern != string::npos) {
+            p = starPattern + 1;               // El * absorbe un carácter más
+            n = ++starName;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') p++;
+    return p == pattern.size();
+}
+
+// Función para listar los archivos del corpus en `directory` (opcionalmente de forma recursiva) cuyo
+// nombre coincide con `glob`. Se ordenan por ruta para que los índices no dependan del sistema de archivos
+vector<string> listCorpusFiles(const string &directory, bool recursive, const string &glob) {
+    vector<string> paths;
+    auto consider = [&](const fs::directory_entry &entry) {
+        if (entry.is_regular_file() && matchesGlob(entry.path().filename().string(), glob)) {
+            paths.push_back(entry.path().string());
+        }
+    };
+    if (recursive) {
+        for (const auto &entry : fs::recursive_directory_iterator(directory)) consider(entry);
+    } else {
+        for (const auto &entry : fs::directory_iterator(directory)) consider(entry);
+    }
+    sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Cola acotada entre etapas del flujo de ingesta: push se bloquea si está llena y pop devuelve
+// false cuando la cola se cerró y ya no quedan elementos
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(max<size_t>(1, capacity)) {}
+
+    void push(T item) {
+        unique_lock<mutex> guard(lock);
+        notFull.wait(guard, [&] { return items.size() < capacity; });
+        items.push_back(move(item));
+        notEmpty.notify_one();
+    }
+
+    bool pop(T &item) {
+        unique_lock<mutex> guard(lock);
+        notEmpty.wait(guard, [&] { return !items.empty() || closed; });
+        if (items.empty()) {
+            return false;                      // Cerrada y vacía: la etapa anterior terminó
+        }
+        item = move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Indica que no habrá más elementos
+    void close() {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;               // Máximo de elementos en espera
+    deque<T> items;                // Elementos en espera
+    bool closed = false;           // La etapa productora terminó
+    mutex lock;
+    condition_variable notFull, notEmpty;
+};
+
+// Normalización del texto para comparar por tokens en lugar de bytes
+struct NormalizeOptions {
+    bool foldCase = true;                // Pasar las letras ASCII a minúsculas
+    bool stripPunctuation = true;        // Descartar la puntuación (si no, cada signo es un token)
+    unordered_set<uint64_t> stopwords;   // Hashes de las palabras vacías que se descartan
+
+    // Identifica la normalización en la caché de huellas (0 se reserva para el modo por bytes)
+    uint64_t key() const {
+        vector<uint64_t> sorted(stopwords.begin(), stopwords.end());
+        sort(sorted.begin(), sorted.end());
+        uint64_t hash = mixHash(1 + foldCase * 2 + stripPunctuation * 4);
+        for (uint64_t word : sorted) hash = mixHash(hash ^ word);
+        return hash | 1;
+    }
+};
+
+// Función para normalizar un texto y separarlo en palabras: los espacios consecutivos cuentan como
+// uno solo, las palabras son secuencias de letras, dígitos o bytes no ASCII (UTF-8) y, según las
+// opciones, se pasan a minúsculas y se descartan la puntuación y las palabras vacías. Devuelve el
+// hash de 64 bits de cada palabra en orden, que identifica al token
+vector<uint64_t> normalizedWordHashes(string_view text, const NormalizeOptions &options) {
+    vector<uint64_t> words;
+    words.reserve(text.size() / 5);            // Alrededor de una palabra cada 5 bytes
+    string word;                               // Palabra en construcción, ya normalizada
+    auto finishWord = [&] {
+        if (!word.empty()) {
+            uint64_t hash = hashShingle(word.data(), word.size());
+            if (options.stopwords.count(hash) == 0) words.push_back(hash);
+            word.clear();
+        }
+    };
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (isalnum(byte) || byte >= 0x80) {
+            word.push_back(options.foldCase ? static_cast<char>(tolower(byte)) : c);
+        } else {
+            finishWord();                      // Espacio o puntuación: termina la palabra
+            if (!isspace(byte) && !options.stripPunctuation) {
+                word.push_back(c);             // El signo se conserva como un token propio
+                finishWord();
+            }
+        }
+    }
+    finishWord();
+    return words;
+}
+
+// Función para leer una lista de palabras vacías (separadas por espacios o saltos de línea); se
+// normalizan igual que el texto. Devuelve false si no se pudo leer el archivo
+bool loadStopwords(const string &path, NormalizeOptions &options) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    NormalizeOptions plain = options;          // Misma normalización, sin descartar nada
+    plain.stopwords.clear();
+    for (uint64_t hash : normalizedWordHashes(file.view(), plain)) {
+        options.stopwords.insert(hash);
+    }
+    return true;
+}
+
+// Parámetros de las huellas que se calculan al cargar cada documento
+struct FingerprintConfig {
+    const NormalizeOptions *normalize = nullptr; // Normalización a tokens (nulo = se compara por bytes)
+    int indexLength = 5;           // Longitud de los shingles del índice invertido (0 = no se calculan)
+    int shingleLength = 5;         // Longitud k de los shingles de los bocetos
+    size_t sketchSize = 256;       // Hashes por boceto bottom-k
+    int signatureFunctions = 0;    // Funciones de la firma MinHash para LSH (0 = no se calcula)
+};
+
+// Corpus cargado: archivos proyectados, vistas de su contenido y huellas de cada documento
+struct Corpus {
+    vector<string> paths;                   // Ruta de cada documento
+    vector<MappedFile> files;               // Proyecciones que mantienen vivas las vistas
+    vector<string_view> documents;          // Contenido de cada documento
+    vector<char> unreadable;                // 1 si el archivo no se pudo leer (se evalúa como vacío)
+    vector<vector<uint64_t>> shingles;      // Shingles distintos para el índice invertido
+    vector<ShingleSketch> sketches;         // Bocetos bottom-k para la contención de Broder
+    vector<vector<uint64_t>> signatures;    // Firmas MinHash para LSH
+    vector<u32string> tokens;               // Identificadores de token de cada documento (modo por tokens)
+    vector<u32string_view> tokenViews;      // Vistas sobre `tokens`, como `documents` para los bytes
+    vector<shared_ptr<const string>> texts; // Textos dados en memoria (API de biblioteca); nulo = archivo
+};
+
+// Función para calcular un hash de 64 bits del contenido completo de un documento, procesando
+// 8 bytes por iteración; identifica al documento en la caché de huellas
+uint64_t contentHash(string_view text) {
+    uint64_t hash = mixHash(text.size() ^ 0x51ed270b27a3c4e5ULL);
+    size_t i = 0;
+    for (; i + 8 <= text.size(); i += 8) {
+        uint64_t word;
+        memcpy(&word, text.data() + i, 8);     // Lectura sin requisitos de alineación
+        hash = mixHash(hash ^ word) * 0x9e3779b97f4a7c15ULL;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, text.data() + i, text.size() - i);
+    return mixHash(hash ^ tail);
+}
+
+// Huellas de un documento guardadas en la caché
+struct CachedFingerprint {
+    uint64_t length = 0;           // Longitud del documento, para descartar colisiones obvias
+    vector<uint64_t> shingles;     // Shingles distintos para el índice invertido
+    ShingleSketch sketch;          // Boceto bottom-k
+    vector<uint64_t> signature;    // Firma MinHash para LSH
+};
+
+// Caché persistente de huellas indexada por el hash del contenido. Formato binario:
+//   cabecera: "PDFC", versión, indexLength, shingleLength, sketchSize, signatureFunctions,
+//             normalización (0 = bytes), entradas
+//   entrada:  hash, longitud, shingles, boceto (conteo + hashes) y firma, cada lista precedida
+//             por su tamaño; todos los enteros en el orden de bytes de la máquina
+// Si la versión o los parámetros no coinciden con los actuales, la caché se ignora y se reescribe
+class FingerprintCache {
+public:
+    static const uint32_t formatVersion = 3;
+
+    // Carga la caché de `path`; devuelve false si no existe, está dañada o usa otros parámetros
+    bool load(const string &path, const FingerprintConfig &config) {
+        entries.clear();
+        error_code ignored;
+        if (!fs::exists(path, ignored)) {
+            return false;
+        }
+        MappedFile file = readFile(path);
+        string_view data = file.view();
+        size_t offset = 0;
+        auto read = [&](void *out, size_t bytes) {
+            if (offset + bytes > data.size()) return false;
+            memcpy(out, data.data() + offset, bytes);
+            offset += bytes;
+            return true;
+        };
+        auto readList = [&](vector<uint64_t> &list) {
+            uint64_t count;
+            if (!read(&count, sizeof count) || count > (data.size() - offset) / sizeof(uint64_t)) return false;
+            list.resize(count);
+            return read(list.data(), count * sizeof(uint64_t));
+        };
+        char magic[4];
+        uint32_t version, indexLength, shingleLength, signatureFunctions;
+        uint64_t sketchSize, normalization, count;
+        if (!read(magic, 4) || memcmp(magic, "PDFC", 4) != 0 || !read(&version, 4) || version != formatVersion ||
+            !read(&indexLength, 4) || !read(&shingleLength, 4) || !read(&sketchSize, 8) ||
+            !read(&signatureFunctions, 4) || !read(&normalization, 8) || !read(&count, 8)) {
+            return false;
+        }
+        if (static_cast<int>(indexLength) != config.indexLength || static_cast<int>(shingleLength) != config.shingleLength ||
+            sketchSize != config.sketchSize || static_cast<int>(signatureFunctions) != config.signatureFunctions ||
+            normalization != (config.normalize ? config.normalize->key() : 0)) {
+            return false;                      // Huellas calculadas con otros parámetros
+        }
+        for (uint64_t e = 0; e < count; ++e) {
+            uint64_t hash, shingleCount;
+            CachedFingerprint entry;
+            if (!read(&hash, 8) || !read(&entry.length, 8) || !readList(entry.shingles) ||
+                !read(&shingleCount, 8) || !readList(entry.sketch.minHashes) || !readList(entry.signature)) {
+                entries.clear();               // Archivo truncado: no confiamos en nada de él
+                return false;
+            }
+            entry.sketch.shingleCount = shingleCount;
+            entries[hash] = move(entry);
+        }
+        return true;
+    }
+
+    // Busca las huellas de un documento por el hash y la longitud de su contenido
+    const CachedFingerprint *find(uint64_t hash, size_t length) const {
+        auto found = entries.find(hash);
+        return (found != entries.end() && found->second.length == length) ? &found->second : nullptr;
+    }
+
+    size_t size() const { return entries.size(); }
+
+    // Escribe la caché con las huellas de todos los documentos del corpus. Se escribe a un archivo
+    // temporal que luego se renombra, para no dejar una caché a medias si el proceso se interrumpe
+    static bool save(const string &path, const FingerprintConfig &config, const Corpus &corpus,
+                     const vector<uint64_t> &hashes) {
+        string temporary = path + ".tmp";
+        ofstream out(temporary, ios::binary | ios::trunc);
+        if (!out) {
+            return false;
+        }
+        vector<char> buffer;                   // Un solo buffer y una sola escritura
+        auto write = [&](const void *data, size_t bytes) {
+            const char *p = static_cast<const char *>(data);
+            buffer.insert(buffer.end(), p, p + bytes);
+        };
+        auto writeList = [&](const vector<uint64_t> &list) {
+            uint64_t count = list.size();
+            write(&count, 8);
+            write(list.data(), count * sizeof(uint64_t));
+        };
+        uint32_t version = formatVersion, indexLength = config.indexLength, shingleLength = config.shingleLength;
+        uint32_t signatureFunctions = config.signatureFunctions;
+        uint64_t sketchSize = config.sketchSize, count = corpus.documents.size();
+        uint64_t normalization = config.normalize ? config.normalize->key() : 0;
+        write("PDFC", 4);
+        write(&version, 4);
+        write(&indexLength, 4);
+        write(&shingleLength, 4);
+        write(&sketchSize, 8);
+        write(&signatureFunctions, 4);
+        write(&normalization, 8);
+        write(&count, 8);
+        for (size_t d = 0; d < corpus.documents.size(); ++d) {
+            uint64_t length = corpus.documents[d].size(), shingleCount = corpus.sketches[d].shingleCount;
+            write(&hashes[d], 8);
+            write(&length, 8);
+            writeList(corpus.shingles[d]);
+            write(&shingleCount, 8);
+            writeList(corpus.sketches[d].minHashes);
+            writeList(corpus.signatures[d]);
+        }
+        out.write(buffer.data(), buffer.size());
+        out.close();
+        if (!out) {
+            return false;
+        }
+        error_code error;
+        fs::rename(temporary, path, error);
+        return !error;
+    }
+
+private:
+    unordered_map<uint64_t, CachedFingerprint> entries; // Huellas por hash de contenido
+};
+
+// Función para calcular las huellas de un documento ya cargado; en el modo por tokens se calculan
+// sobre `words`, los hashes de sus palabras normalizadas
+void fingerprintDocument(Corpus &corpus, int d, const FingerprintConfig &config, const vector<uint64_t> &words) {
+    if (config.normalize != nullptr) {
+        // Modo por tokens: los shingles son k palabras consecutivas
+        vector<uint64_t> hashes = shingleHashes(words.data(), words.size(), config.shingleLength);
+        corpus.sketches[d] = buildSketch(hashes, config.sketchSize);
+        if (config.signatureFunctions > 0) {
+            corpus.signatures[d] = minHashSignature(hashes, config.signatureFunctions);
+        }
+        if (config.indexLength > 0) {
+            corpus.shingles[d] = config.indexLength == config.shingleLength
+                                     ? move(hashes)
+                                     : shingleHashes(words.data(), words.size(), config.indexLength);
+        }
+        return;
+    }
+    string_view document = corpus.documents[d];
+    vector<uint64_t> hashes = shingleHashes(document, config.shingleLength);
+    corpus.sketches[d] = buildSketch(hashes, config.sketchSize);
+    if (config.signatureFunctions > 0) {
+        corpus.signatures[d] = minHashSignature(hashes, config.signatureFunctions);
+    }
+    if (config.indexLength > 0) {
+        // Si ambas longitudes coinciden reutilizamos los hashes ya calculados
+        corpus.shingles[d] = config.indexLength == config.shingleLength ? move(hashes)
+                                                                        : shingleHashes(document, config.indexLength);
+    }
+}
+
+// Función para cargar el corpus con un flujo en dos etapas: varios hilos lectores proyectan los
+// archivos y los envían por una cola acotada a los hilos que calculan las huellas, de modo que el
+// cálculo de shingles y bocetos se traslapa con la E/S. Si se da una caché, los documentos cuyo
+// contenido ya está en ella no se vuelven a procesar; `hashes` recibe el hash de cada documento.
+// Con `control`, cada documento procesado informa su avance y, si se cancela, los lectores dejan de
+// tomar archivos y los documentos ya leídos no se procesan (el corpus queda incompleto). Los archivos
+// que no se pueden abrir quedan marcados en `unreadable` sin escribir en cerr (ver reportUnreadable)
+Corpus ingestCorpus(vector<string> paths, const FingerprintConfig &config, int readerThreads, int workerThreads,
+                    const FingerprintCache *cache = nullptr, vector<uint64_t> *hashes = nullptr,
+                    size_t *reused = nullptr, vector<shared_ptr<const string>> texts = {},
+                    ScoringControl *control = nullptr) {
+    Corpus corpus;
+    size_t n = paths.size();
+    corpus.paths = move(paths);
+    corpus.texts = move(texts);             // Si se dan, los textos no nulos no se leen de su ruta
+    corpus.texts.resize(n);
+    corpus.files.resize(n);
+    corpus.documents.resize(n);
+    corpus.unreadable.assign(n, 0);
+    corpus.shingles.resize(n);
+    corpus.sketches.resize(n);
+    corpus.signatures.resize(n);
+
+    if (hashes != nullptr) {
+        hashes->assign(n, 0);
+    }
+    vector<vector<uint64_t>> words(n);   // Hashes de las palabras de cada documento (modo por tokens)
+    atomic<size_t> cacheHits(0);                         // Documentos tomados de la caché
+    BoundedQueue<int> loaded(4 * max(1, workerThreads)); // Documentos leídos pendientes de procesar
+    atomic<size_t> nextFile(0);                          // Siguiente archivo a leer
+    atomic<int> activeReaders(max(1, readerThreads));
+    if (control != nullptr) {
+        control->start(n);
+    }
+    vector<thread> threads;
+    for (int r = 0; r < max(1, readerThreads); ++r) {
+        threads.emplace_back([&] {
+            for (size_t d = nextFile++; d < n; d = nextFile++) {
+                if (control != nullptr && control->stopped()) {
+                    break;                                     // Cancelado: no se leen más archivos
+                }
+                if (corpus.texts[d] != nullptr) {
+                    corpus.documents[d] = *corpus.texts[d];    // Texto en memoria: no se copia
+                } else {
+                    bool opened;
+                    corpus.files[d] = readFile(corpus.paths[d], &opened); // Cada hilo escribe posiciones distintas
+                    corpus.documents[d] = corpus.files[d].view();
+                    corpus.unreadable[d] = !opened;
+                }
+                loaded.push(static_cast<int>(d));
+            }
+            if (--activeReaders == 0) {
+                loaded.close();                                // El último lector cierra la cola
+            }
+        });
+    }
+    for (int w = 0; w < max(1, workerThreads); ++w) {
+        threads.emplace_back([&] {
+            int d;
+            while (loaded.pop(d)) {
+                if (control != nullptr && control->stopped()) {
+                    continue;                  // Se vacía la cola para que los lectores no se bloqueen
+                }
+                if (config.normalize != nullptr) {     // Los tokens hacen falta aunque las huellas estén en caché
+                    words[d] = normalizedWordHashes(corpus.documents[d], *config.normalize);
+                }
+                if (cache != nullptr || hashes != nullptr) {
+                    uint64_t hash = contentHash(corpus.documents[d]);
+                    if (hashes != nullptr) {
+                        (*hashes)[d] = hash;
+                    }
+                    const CachedFingerprint *cached = cache ? cache->find(hash, corpus.documents[d].size()) : nullptr;
+                    if (cached != nullptr) {   // El contenido no cambió: reutilizamos sus huellas
+                        corpus.shingles[d] = cached->shingles;
+                        corpus.sketches[d] = cached->sketch;
+                        corpus.signatures[d] = cached->signature;
+                        cacheHits++;
+                        if (control != nullptr) control->taskDone();
+                        continue;
+                    }
+                }
+                fingerprintDocument(corpus, d, config, words[d]);
+                if (control != nullptr) control->taskDone();
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    if (config.normalize != nullptr) {
+        // Asignamos identificadores densos de 32 bits en orden de aparición, de modo que el mismo
+        // corpus produce siempre los mismos tokens y el autómata compara enteros pequeños
+        unordered_map<uint64_t, char32_t> ids;
+        corpus.tokens.resize(n);
+        corpus.tokenViews.resize(n);
+        for (size_t d = 0; d < n; ++d) {
+            corpus.tokens[d].reserve(words[d].size());
+            for (uint64_t word : words[d]) {
+                corpus.tokens[d].push_back(ids.emplace(word, static_cast<char32_t>(ids.size())).first->second);
+            }
+            corpus.tokenViews[d] = corpus.tokens[d];
+            vector<uint64_t>().swap(words[d]); // Liberamos los hashes en cuanto dejan de hacer falta
+        }
+    }
+    if (reused != nullptr) {
+        *reused = cacheHits;
+    }
+    return corpus;
+}
+
+// Función para informar en cerr los documentos del corpus que no se pudieron leer (línea de comandos)
+void reportUnreadable(const Corpus &corpus) {
+    for (size_t d = 0; d < corpus.paths.size(); ++d) {
+        if (corpus.unreadable[d]) {
+            cerr << "No se pudo leer " << corpus.paths[d] << endl;
+        }
+    }
+}
+
+// Generador de texto sintético para las pruebas de rendimiento: palabras de 2 a 10 letras al azar
+// separadas por espacios y con algún punto. Las letras no salen de un vocabulario para que dos textos
+// independientes casi no compartan subcadenas y la proporción de plagio sea la que se pide
+string syntheticText(mt19937 &rng, size_t length) {
+    string text;
+    text.reserve(length + 16);
+    while (text.size() < length) {
+        int letters = 2 + rng() % 9;
+        for (int l = 0; l < letters; ++l) text += static_cast<char>('a' + rng() % 26);
+        text += rng() % 12 == 0 ? ". " : " ";
+    }
+    text.resize(length);
+    return text;
+}
+
+// Función para crear una copia de `source` plagiada en proporción `rate`: el texto se recorre en bloques
+// de 32 a 256 caracteres y cada bloque se copia con probabilidad `rate` o se reemplaza por texto nuevo
+// de la misma longitud, de modo que la cobertura esperada del par es aproximadamente `rate`
+string plagiarize(const string &source, double rate, mt19937 &rng) {
+    string copy;
+    copy.reserve(source.size());
+    uniform_real_distribution<double> coin(0.0, 1.0);
+    for (size_t start = 0; start < source.size();) {
+        size_t block = min<size_t>(32 + rng() % 225, source.size() - start);
+        copy += coin(rng) < rate ? source.substr(start, block) : syntheticText(rng, block);
+        start += block;
+    }
+    return copy;
+}
+
+// Función para crear un corpus sintético de `count` documentos de `length` caracteres; cada documento
+// impar es una copia plagiada en proporción `rate` del documento anterior
+vector<string> syntheticCorpus(size_t count, size_t length, double rate, mt19937 &rng) {
+    vector<string> corpus;
+    for (size_t d = 0; d < count; ++d) {
+        corpus.push_back(d % 2 == 1 ? plagiarize(corpus.back(), rate, rng) : syntheticText(rng, length));
+    }
+    return corpus;
+}
+
+// Opciones del conjunto de pruebas de rendimiento (--bench)
+struct BenchmarkOptions {
+    string filter;                             // Sólo los núcleos cuyo nombre contiene este texto
+    string csvPath;                            // Resultados en CSV para graficar las curvas
+    double rate = 0.3;                         // Proporción de plagio de los pares sintéticos
+    int threads = 1;                           // Hilos de generateSimilarityMatrix
+};
+
+volatile uint64_t benchmarkSink = 0;           // Evita que el compilador elimine los núcleos medidos
+
+// Función para medir `run` (que devuelve un valor de control): se repite hasta acumular al menos
+// `minSeconds` y se devuelven los segundos por ejecución
+template <typename Function>
+double measureKernel(Function run, double minSeconds = 0.2) {
+    using Clock = chrono::steady_clock;
+    benchmarkSink += static_cast<uint64_t>(run()); // Calentamiento: cachés, arena y memoria reservada
+    size_t repetitions = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        benchmarkSink += static_cast<uint64_t>(run());
+        repetitions++;
+        elapsed = chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return elapsed / repetitions;
+}
+
+// Función para ejecutar el conjunto de pruebas de rendimiento sobre textos sintéticos: cada núcleo se
+// mide sobre tamaños crecientes (longitud del documento o número de documentos) y se informa el
+// tiempo por operación y el exponente de escalado entre tamaños consecutivos, log(t2/t1)/log(n2/n1):
+// ~1 es lineal y ~2 cuadrático. Devuelve 0 si se pudieron escribir los resultados
+int runBenchmarks(const BenchmarkOptions &options, int minLength, int k) {
+    mt19937 rng(7);                            // Semilla fija: mismos textos en cada ejecución
+    ofstream csv;
+    if (!options.csvPath.empty()) {
+        csv.open(options.csvPath, ios::trunc);
+        if (!csv) {
+            cerr << "No se pudo crear " << options.csvPath << endl;
+            return 1;
+        }
+        csv << "kernel,size,seconds" << endl;
+    }
+
+    // Mide `run(size)` para cada tamaño y muestra la curva; `unit` describe el tamaño
+    auto curve = [&](const string &name, const char *unit, const vector<size_t> &sizes, auto prepare, auto run) {
+        if (name.find(options.filter) == string::npos) return;
+        cout << name << endl;
+        double previousTime = 0.0;
+        size_t previousSize = 0;
+        for (size_t size : sizes) {
+            auto input = prepare(size);
+            double seconds = measureKernel([&] { return run(input); });
+            cout << "  " << setw(8) << size << " " << unit << ": " << setw(12) << fixed << setprecision(3)
+                 << seconds * 1e6 << " us";
+            if (previousSize > 0) {
+                cout << "  exponente " << setprecision(2) << log(seconds / previousTime) / log(double(size) / previousSize);
+            }
+            cout << endl;
+            if (csv.is_open()) csv << name << "," << size << "," << setprecision(9) << seconds << endl;
+            previousTime = seconds;
+            previousSize = size;
+        }
+    };
+    // Par sintético (original, copia plagiada) de longitud `length`
+    auto makePair = [&](size_t length) {
+        string original = syntheticText(rng, length);
+        string copy = plagiarize(original, options.rate, rng);
+        return make_pair(original, copy);
+    };
+    using TextPair = pair<string, string>;
+
+    // readFile sobre un archivo temporal, incluida la lectura de todo el contenido proyectado
+    string temporary = (fs::temp_directory_path() / "plagiarism_bench.txt").string();
+    curve("readFile", "bytes", {1 << 16, 1 << 18, 1 << 20, 1 << 22, 1 << 24}, [&](size_t size) {
+        ofstream(temporary, ios::binary | ios::trunc) << syntheticText(rng, size);
+        return temporary;
+    }, [](const string &path) {
+        MappedFile file = readFile(path);
+        uint64_t sum = 0;
+        for (char c : file.view()) sum += static_cast<unsigned char>(c);
+        return sum;
+    });
+    error_code ignored;
+    fs::remove(temporary, ignored);
+
+    curve("findCommonSubstrings (dp)", "chars", {256, 512, 1024, 2048, 4096}, makePair, [&](const TextPair &p) {
+        return findCommonSubstrings(string_view(p.first), string_view(p.second), minLength).size();
+    });
+    for (auto mode : {SimilarityMode::Mass, SimilarityMode::Coverage}) {
+        const char *label = mode == SimilarityMode::Mass ? "mass" : "coverage";
+        curve(string("similarityMetric (sam, ") + label + ")", "chars", {1024, 4096, 16384, 65536}, makePair,
+              [&](const TextPair &p) {
+                  return similarityMetric(string_view(p.first), string_view(p.second), minLength,
+                                          SubstringBackend::SuffixAutomaton, false, mode) * 1e6;
+              });
+        curve(string("similarityMetric (dp, ") + label + ")", "chars", {256, 512, 1024, 2048}, makePair,
+              [&](const TextPair &p) {
+                  return similarityMetric(string_view(p.first), string_view(p.second), minLength,
+                                          SubstringBackend::DynamicProgramming, false, mode) * 1e6;
+              });
+    }
+    curve("editDistance (dp)", "chars", {256, 512, 1024, 2048, 4096}, makePair, [](const TextPair &p) {
+        return editDistance(string_view(p.first), string_view(p.second));
+    });
+    curve("myersEditDistance", "chars", {1024, 2048, 4096, 8192, 16384}, makePair, [](const TextPair &p) {
+        return myersEditDistance(p.first, p.second);
+    });
+    curve("boundedEditDistance (T = 64)", "chars", {1024, 4096, 16384, 65536}, makePair, [](const TextPair &p) {
+        return boundedEditDistance(string_view(p.first), string_view(p.second), 64);
+    });
+    curve("broderContainment (legacy)", "chars", {64, 128, 256, 512, 1024}, makePair, [](const TextPair &p) {
+        return broderContainment(string_view(p.first), string_view(p.second)) * 1e6;
+    });
+    curve("shingleContainment (exact)", "chars", {1024, 4096, 16384, 65536}, makePair, [k](const TextPair &p) {
+        return shingleContainment(string_view(p.first), string_view(p.second), k) * 1e6;
+    });
+    curve("highlightSimilarities", "chars", {1024, 4096, 16384, 65536}, makePair, [&](const TextPair &p) {
+        string out;
+        highlightSimilarities(p.first, p.second, minLength, out);
+        return out.size();
+    });
+
+    // Autómata de sufijos con la tabla directa de la raíz frente a sólo listas enlazadas, sobre bytes y
+    // sobre tokens (cada palabra del texto es un identificador): se construye el autómata de la fila y
+    // se recorre el otro texto, como en cada par de mass y coverage
+    auto automatonCurves = [&](auto symbol, const char *alphabet) {
+        using CharT = decltype(symbol);
+        struct AutomatonInput {
+            basic_string<CharT> row, other;
+            BasicSuffixAutomaton<CharT, true> table;
+            BasicSuffixAutomaton<CharT, false> lists;
+        };
+        auto prepare = [&](size_t size) {
+            auto input = make_shared<AutomatonInput>();
+            mt19937 pairRng(size);                 // Mismo par para ambas variantes
+            string original = syntheticText(pairRng, size);
+            string copy = plagiarize(original, options.rate, pairRng);
+            if constexpr (is_same_v<CharT, char>) {
+                input->row = original;
+                input->other = copy;
+            } else {
+                unordered_map<string, char32_t> ids;
+                auto encode = [&](const string &text, u32string &out) {
+                    for (size_t start = 0; start < text.size();) {
+                        size_t end = min(text.find(' ', start), text.size());
+                        if (end > start) {
+                            string word = text.substr(start, end - start);
+                            out.push_back(ids.emplace(word, static_cast<char32_t>(ids.size())).first->second);
+                        }
+                        start = end + 1;
+                    }
+                };
+                encode(original, input->row);
+                encode(copy, input->other);
+            }
+            return input;
+        };
+        auto walk = [](auto &automaton, const AutomatonInput &input) {
+            automaton.build(basic_string_view<CharT>(input.row));
+            long long total = 0;
+            automaton.matchingStatistics(basic_string_view<CharT>(input.other),
+                                         [&](int, int, int length) { total += length; });
+            return total;
+        };
+        for (bool table : {false, true}) {
+            curve(string("suffixAutomaton (") + alphabet + (table ? ", tabla de la raíz)" : ", listas)"), "chars",
+                  {1024, 4096, 16384, 65536}, prepare, [&](const shared_ptr<AutomatonInput> &input) {
+                      return table ? walk(input->table, *input) : walk(input->lists, *input);
+                  });
+        }
+    };
+    automatonCurves(char(), "bytes");
+    automatonCurves(char32_t(), "tokens");
+
+    // Matriz completa sobre corpus sintéticos de documentos de 2000 caracteres, con y sin índice
+    struct CorpusInput {
+        vector<string> texts;
+        vector<string_view> views;
+        vector<vector<uint64_t>> shingles;
+    };
+    auto makeCorpus = [&](size_t count) {
+        auto input = make_shared<CorpusInput>();
+        input->texts = syntheticCorpus(count, 2000, options.rate, rng);
+        for (const auto &text : input->texts) {
+            input->views.push_back(text);
+            input->shingles.push_back(shingleHashes(string_view(text), minLength));
+        }
+        return input;
+    };
+    for (bool prune : {false, true}) {
+        curve(string("generateSimilarityMatrix (") + (prune ? "con índice" : "sin índice") + ")", "docs",
+              {16, 32, 64, 128}, makeCorpus, [&](const shared_ptr<CorpusInput> &input) {
+                  ShingleIndex index;
+                  if (prune) index.build(input->shingles);
+                  TopKCollector top(10, options.threads);
+                  generateSimilarityMatrix(input->views, minLength, nullptr, &top, SubstringBackend::SuffixAutomaton,
+                                           options.threads, prune ? &index : nullptr);
+                  return top.result().size();
+              });
+    }
+
+    // Control del generador: la cobertura medida debe seguir a la proporción de plagio pedida
+    if (string("plagiarize").find(options.filter) != string::npos || options.filter.empty()) {
+        cout << "plagiarize (cobertura medida de pares de 16384 caracteres)" << endl;
+        for (double rate : {0.0, 0.25, 0.5, 0.75, 1.0}) {
+            string original = syntheticText(rng, 16384);
+            string copy = plagiarize(original, rate, rng);
+            double coverage = similarityMetric(string_view(original), string_view(copy), minLength,
+                                               SubstringBackend::SuffixAutomaton, false, SimilarityMode::Coverage);
+            cout << "  proporción " << fixed << setprecision(2) << rate << ": cobertura " << setprecision(3)
+                 << coverage << endl;
+        }
+    }
+    if (csv.is_open()) {
+        csv.close();
+        if (csv.fail()) {
+            cerr << "No se pudo escribir " << options.csvPath << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Opciones de línea de comandos
+enum class ContainmentMode {
+    Sketch,  // Estimación con bocetos MinHash bottom-k (por defecto)
+    Exact,   // Contención exacta sobre k-shingles
+    Legacy   // Todas las subcadenas de ambos documentos (O(m^2) cadenas)
+};
+
+struct Options {
+    SubstringBackend backend = SubstringBackend::SuffixAutomaton; // Motor de subcadenas comunes
+    SimilarityMode similarity = SimilarityMode::Mass;             // Medida de similitud de los pares
+    ContainmentMode containment = ContainmentMode::Sketch;        // Cálculo de la contención de Broder
+    int shingleLength = 5;                                        // Longitud k de los shingles
+    int sketchSize = 256;                                         // Hashes por boceto bottom-k
+    bool validateSketch = false;                                  // Comparar boceto contra el valor exacto
+    bool verifySpans = false;                                     // Verificar el texto si dos huellas coinciden
+    int maxEditDistance = -1;                                     // Umbral para la distancia de edición (-1 = exacta)
+    EditKernel editKernel = EditKernel::BitParallel;              // Implementación de la distancia de edición
+    bool verifyEdit = false;                                      // Modo de prueba de los núcleos de edición
+    bool benchShingles = false;                                   // Medir la generación de shingles
+    bool benchmark = false;                                       // Pruebas de rendimiento sintéticas (--bench)
+    bool stats = false;                                           // Mostrar tiempos y contadores al final
+    string statsJsonPath;                                         // Tiempos y contadores en JSON
+    BenchmarkOptions bench;                                       // Filtro, CSV y proporción de plagio de --bench
+    int threads = max(1u, thread::hardware_concurrency());        // Hilos para la matriz de similitud
+    bool prune = true;                                            // Usar el índice de shingles para podar pares
+    int blockRows = 1;                                            // Filas por bloque del recorrido (1 = por filas)
+    int blockCache = 0;                                           // KiB de columnas por bloque (0 = mitad de la L2)
+    int minShared = 1;                                            // Shingles compartidos para ser candidato
+    int lshBands = 0;                                             // Bandas LSH (0 = modo exacto)
+    int lshRows = 0;                                              // Filas por banda LSH
+    int lshSample = 0;                                            // Documentos para estimar el recall de LSH
+    string storage = "none";                                      // Matriz de similitud: none, auto, packed o sparse
+    int topCount = 10;                                            // Pares que se incluyen en el reporte
+    string directory = "dataset";                                 // Carpeta del corpus
+    bool recursive = false;                                       // Recorrer también las subcarpetas
+    string glob = "*";                                            // Patrón de nombres de archivo
+    string cachePath;                                             // Caché persistente de huellas (vacío = sin caché)
+    string queryDirectory;                                        // Entregas nuevas a comparar contra el corpus
+    int shardIndex = -1;                                          // Fragmento de este nodo (--shard i/N)
+    int shardCount = 0;                                           // Número de fragmentos (0 = sin fragmentar)
+    string shardOutput;                                           // Resultado parcial del fragmento
+    int shardMemory = 1024;                                       // MiB de documentos por bloque de la matriz
+    int tileSize = 0;                                             // Documentos por bloque (0 = según la memoria)
+    vector<string> mergePaths;                                    // Resultados parciales a combinar
+    string topStorePath;                                          // Mejores pares guardados entre ejecuciones
+    string reportDirectory;                                       // Textos resaltados en un archivo por par
+    string htmlPath = "similar_texts.html";                       // Reporte HTML (vacío = sin reporte)
+    string exportPath;                                            // Resultados para otras herramientas
+    string exportFormat = "jsonl";                                // Formato de exportación: jsonl o binary
+    bool exportAll = false;                                       // Exportar todos los pares de la matriz
+    bool exportMetrics = true;                                    // Exportar edición, contención y coincidencias
+    double threshold = 0.0;                                       // Similitud mínima que guarda la matriz dispersa
+    bool tokenize = false;                                        // Comparar por tokens normalizados
+    NormalizeOptions normalize;                                   // Normalización del modo por tokens
+};
+
+// Función para leer un argumento entero mayor o igual que `minimum` (positivo por defecto); devuelve
+// false si no es válido
+bool parsePositive(const char *text, int &value, int minimum = 1) {
+    char *end = nullptr;
+    long parsed = strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || parsed < minimum || parsed > INT32_MAX) {
+        cerr << "Valor inválido: " << text << endl;
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// Función para interpretar los argumentos de línea de comandos; devuelve false si hay un error
+bool parseArguments(int argc, char *argv[], Options &options) {
+    string stopwordsPath;                      // Se lee al final, con la normalización ya decidida
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg == "--backend" && a + 1 < argc) {
+            string value = argv[++a];
+            if (value == "dp") {
+                options.backend = SubstringBackend::DynamicProgramming;
+            } else if (value == "sam") {
+                options.backend = SubstringBackend::SuffixAutomaton;
+            } else {
+                cerr << "Motor desconocido: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--similarity" && a + 1 < argc) {
+            string value = argv[++a];
+            if (value == "mass") {
+                options.similarity = SimilarityMode::Mass;
+            } else if (value == "coverage") {
+                options.similarity = SimilarityMode::Coverage;
+            } else {
+                cerr << "Medida de similitud desconocida: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--containment" && a + 1 < argc) {
+            string value = argv[++a];
+            if (value == "sketch") {
+                options.containment = ContainmentMode::Sketch;
+            } else if (value == "exact") {
+                options.containment = ContainmentMode::Exact;
+            } else if (value == "legacy") {
+                options.containment = ContainmentMode::Legacy;
+            } else {
+                cerr << "Modo de contención desconocido: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--shingle-k" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.shingleLength)) return false;
+        } else if (arg == "--sketch-size" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.sketchSize)) return false;
+        } else if (arg == "--max-edit" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.maxEditDistance, 0)) return false; // 0 = sólo copias exactas
+        } else if (arg == "--edit-kernel" && a + 1 < argc) {
+            string value = argv[++a];
+            if (value == "dp") {
+                options.editKernel = EditKernel::DynamicProgramming;
+            } else if (value == "myers") {
+                options.editKernel = EditKernel::BitParallel;
+            } else {
+                cerr << "Núcleo de edición desconocido: " << value << endl;
+                return false;
+            }
+        } else if (arg == "--threads" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.threads)) return false;
+        } else if (arg == "--block-rows" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.blockRows)) return false;
+        } else if (arg == "--block-cache" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.blockCache)) return false;
+        } else if (arg == "--min-shared" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.minShared)) return false;
+        } else if (arg == "--lsh" && a + 1 < argc) {
+            string value = argv[++a];          // Formato BxR, por ejemplo 20x5
+            size_t split = value.find('x');
+            if (split == string::npos || !parsePositive(value.substr(0, split).c_str(), options.lshBands) ||
+                !parsePositive(value.substr(split + 1).c_str(), options.lshRows)) {
+                cerr << "Formato de --lsh inválido: " << value << " (se espera BxR)" << endl;
+                return false;
+            }
+        } else if (arg == "--lsh-sample" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.lshSample)) return false;
+        } else if (arg == "--storage" && a + 1 < argc) {
+            options.storage = argv[++a];
+            if (options.storage != "none" && options.storage != "auto" && options.storage != "packed" &&
+                options.storage != "sparse") {
+                cerr << "Almacenamiento desconocido: " << options.storage << endl;
+                return false;
+            }
+        } else if (arg == "--dir" && a + 1 < argc) {
+            options.directory = argv[++a];
+        } else if (arg == "--recursive") {
+            options.recursive = true;
+        } else if (arg == "--glob" && a + 1 < argc) {
+            options.glob = argv[++a];
+        } else if (arg == "--query" && a + 1 < argc) {
+            options.queryDirectory = argv[++a];
+        } else if (arg == "--shard" && a + 1 < argc) {
+            string value = argv[++a];          // Formato i/N, con 0 <= i < N
+            size_t split = value.find('/');
+            char *end = nullptr;
+            long index = split == string::npos ? -1 : strtol(value.c_str(), &end, 10);
+            if (split == string::npos || end != value.c_str() + split || split == 0 || index < 0 ||
+                !parsePositive(value.substr(split + 1).c_str(), options.shardCount) || index >= options.shardCount) {
+                cerr << "Formato de --shard inválido: " << value << " (se espera i/N con 0 <= i < N)" << endl;
+                return false;
+            }
+            options.shardIndex = static_cast<int>(index);
+        } else if (arg == "--shard-output" && a + 1 < argc) {
+            options.shardOutput = argv[++a];
+        } else if (arg == "--shard-memory" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.shardMemory)) return false;
+        } else if (arg == "--tile-size" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.tileSize)) return false;
+        } else if (arg == "--merge" && a + 1 < argc) {
+            options.mergePaths.push_back(argv[++a]);
+        } else if (arg == "--html" && a + 1 < argc) {
+            options.htmlPath = argv[++a];
+        } else if (arg == "--no-html") {
+            options.htmlPath.clear();
+        } else if (arg == "--export" && a + 1 < argc) {
+            options.exportPath = argv[++a];
+        } else if (arg == "--export-format" && a + 1 < argc) {
+            options.exportFormat = argv[++a];
+            if (options.exportFormat != "jsonl" && options.exportFormat != "binary") {
+                cerr << "Formato de exportación desconocido: " << options.exportFormat << endl;
+                return false;
+            }
+        } else if (arg == "--tokens") {
+            options.tokenize = true;
+        } else if (arg == "--keep-case") {
+            options.tokenize = true;
+            options.normalize.foldCase = false;
+        } else if (arg == "--keep-punctuation") {
+            options.tokenize = true;
+            options.normalize.stripPunctuation = false;
+        } else if (arg == "--stopwords" && a + 1 < argc) {
+            options.tokenize = true;
+            stopwordsPath = argv[++a];
+        } else if (arg == "--export-all") {
+            options.exportAll = true;
+        } else if (arg == "--export-metrics" && a + 1 < argc) {
+            string metrics = argv[++a];
+            if (metrics != "all" && metrics != "similarity") {
+                cerr << "Métricas de exportación desconocidas: " << metrics << endl;
+                return false;
+            }
+            options.exportMetrics = metrics == "all";
+        } else if (arg == "--split-report" && a + 1 < argc) {
+            options.reportDirectory = argv[++a];
+        } else if (arg == "--top-store" && a + 1 < argc) {
+            options.topStorePath = argv[++a];
+        } else if (arg == "--cache" && a + 1 < argc) {
+            options.cachePath = argv[++a];
+        } else if (arg == "--top" && a + 1 < argc) {
+            if (!parsePositive(argv[++a], options.topCount)) return false;
+        } else if (arg == "--threshold" && a + 1 < argc) {
+            char *end = nullptr;
+            options.threshold = strtod(argv[++a], &end);
+            if (*end != '\0' || options.threshold < 0.0) {
+                cerr << "Umbral inválido: " << argv[a] << endl;
+                return false;
+            }
+        } else if (arg == "--no-prune") {
+            options.prune = false;
+        } else if (arg == "--bench-shingles") {
+            options.benchShingles = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--stats-json" && a + 1 < argc) {
+            options.statsJsonPath = argv[++a];
+        } else if (arg == "--bench") {
+            options.benchmark = true;
+        } else if (arg == "--bench-filter" && a + 1 < argc) {
+            options.benchmark = true;
+            options.bench.filter = argv[++a];
+        } else if (arg == "--bench-csv" && a + 1 < argc) {
+            options.benchmark = true;
+            options.bench.csvPath = argv[++a];
+        } else if (arg == "--bench-rate" && a + 1 < argc) {
+            char *end = nullptr;
+            options.benchmark = true;
+            options.bench.rate = strtod(argv[++a], &end);
+            if (*end != '\0' || options.bench.rate < 0.0 || options.bench.rate > 1.0) {
+                cerr << "Proporción de plagio inválida: " << argv[a] << endl;
+                return false;
+            }
+        } else if (arg == "--verify-edit") {
+            options.verifyEdit = true;
+        } else if (arg == "--validate-sketch") {
+            options.validateSketch = true;
+        } else if (arg == "--verify-spans") {
+            options.verifySpans = true;
+        } else {
+            cerr << "Argumento desconocido: " << arg << endl;
+            return false;
+        }
+    }
+    if (!stopwordsPath.empty() && !loadStopwords(stopwordsPath, options.normalize)) {
+        cerr << "No se pudo leer la lista de palabras vacías " << stopwordsPath << endl;
+        return false;
+    }
+    return true;
+}
+
+// Función para calcular la distancia de edición del par (i, j) según las opciones: acotada por
+// --max-edit (T + 1 si se supera), con el núcleo bit-paralelo o con la DP de dos filas. Con --tokens
+// se mide en tokens; el núcleo de Myers indexa su tabla por byte, así que los tokens usan la DP
+double pairEditDistance(const Corpus &corpus, int i, int j, const Options &options) {
+    if (options.tokenize) {
+        u32string_view tokens1 = corpus.tokenViews[i], tokens2 = corpus.tokenViews[j];
+        return options.maxEditDistance >= 0 ? boundedEditDistance(tokens1, tokens2, options.maxEditDistance)
+                                            : editDistance(tokens1, tokens2);
+    }
+    string_view str1 = corpus.documents[i], str2 = corpus.documents[j];
+    if (options.maxEditDistance >= 0) {
+        return boundedEditDistance(str1, str2, options.maxEditDistance);
+    } else if (options.editKernel == EditKernel::BitParallel) {
+        return myersEditDistance(str1, str2);  // Núcleo bit-paralelo
+    }
+    return editDistance(str1, str2);
+}
+
+// Función para calcular la contención exacta sobre k-shingles de bytes o, con --tokens, de tokens
+double exactContainment(const Corpus &corpus, int i, int j, const Options &options) {
+    if (options.tokenize) {
+        return shingleContainment(corpus.tokenViews[i], corpus.tokenViews[j], options.shingleLength);
+    }
+    return shingleContainment(corpus.documents[i], corpus.documents[j], options.shingleLength);
+}
+
+// Función para calcular la contención de Broder del par (i, j) según el modo elegido
+double pairContainment(const Corpus &corpus, int i, int j, const Options &options) {
+    if (options.containment == ContainmentMode::Legacy) {
+        return options.tokenize ? broderContainment(corpus.tokenViews[i], corpus.tokenViews[j], options.verifySpans)
+                                : broderContainment(corpus.documents[i], corpus.documents[j], options.verifySpans);
+    } else if (options.containment == ContainmentMode::Exact) {
+        return exactContainment(corpus, i, j, options);
+    }
+    return sketchContainment(corpus.sketches[i], corpus.sketches[j]);
+}
+
+// Resultado de un par que comparten la exportación y el reporte HTML: las métricas y las
+// coincidencias se calculan la primera vez que se piden y los mejores pares las conservan para no
+// repetir los núcleos caros. Cada coincidencia es un fragmento maximal del segundo documento (pos1)
+// con la posición de su primera aparición en el primero (pos2)
+struct PairResult {
+    int first, second;
+    double similarity;
+    optional<double> editDistance, containment;
+    optional<vector<MatchSpan>> spans;
+};
+
+// Función para crear los resultados (aún sin métricas) de una lista de pares
+vector<PairResult> makePairResults(const vector<ScoredPair> &pairs) {
+    vector<PairResult> results;
+    results.reserve(pairs.size());
+    for (const auto &pair : pairs) {
+        results.push_back({pair.first, pair.second, pair.similarity, nullopt, nullopt, nullopt});
+    }
+    return results;
+}
+
+// Memoria de un hilo para completar las métricas de los pares: la fila del último par preparada con
+// prepareRowMetrics, que se reutiliza mientras los pares compartan el primer documento
+struct MetricsScratch {
+    PairScratch<char> bytes;
+    PairScratch<char32_t> tokens;
+    int row = -1;                              // Documento preparado (-1 = ninguno)
+};
+
+// Función para calcular las métricas del par (i, j) recorriendo el documento j sobre el autómata del i
+template <typename CharT>
+PairMetrics documentPairMetrics(const vector<basic_string_view<CharT>> &views, int i, int j, int minLength,
+                                const Options &options, int &preparedRow, PairScratch<CharT> &local) {
+    if (preparedRow != i) {
+        prepareRowMetrics(views[i], minLength, options.shingleLength, local);
+        preparedRow = i;
+    }
+    return rowPairMetrics(views[i], views[j], minLength, options.maxEditDistance, local);
+}
+
+// Función para calcular las métricas del par que todavía faltan. Con --containment exact, la
+// contención (y, con --max-edit, la distancia acotada) sale de un solo recorrido con rowPairMetrics
+void completePairMetrics(PairResult &result, const Corpus &corpus, int minLength, const Options &options,
+                         MetricsScratch &scratch) {
+    if (!result.containment && options.containment == ContainmentMode::Exact) {
+        ScopedTimer timer(RunStats::Containment);
+        PairMetrics metrics =
+            options.tokenize
+                ? documentPairMetrics(corpus.tokenViews, result.first, result.second, minLength, options, scratch.row,
+                                      scratch.tokens)
+                : documentPairMetrics(corpus.documents, result.first, result.second, minLength, options, scratch.row,
+                                      scratch.bytes);
+        result.containment = metrics.containment;
+        if (!result.editDistance && metrics.editDistance) {
+            result.editDistance = *metrics.editDistance;
+        }
+    }
+    if (!result.editDistance) {
+        ScopedTimer timer(RunStats::EditDistance);
+        result.editDistance = pairEditDistance(corpus, result.first, result.second, options);
+    }
+    if (!result.containment) {
+        ScopedTimer timer(RunStats::Containment);
+        result.containment = pairContainment(corpus, result.first, result.second, options);
+    }
+}
+
+// Función para obtener las coincidencias maximales del par, calculándolas la primera vez.
+// `automaton` es opcional y debe ser el del primer documento
+const vector<MatchSpan> &pairSpans(PairResult &result, const Corpus &corpus, int minLength,
+                                   const SuffixAutomaton *automaton = nullptr) {
+    if (!result.spans) {
+        string_view str1 = corpus.documents[result.first], str2 = corpus.documents[result.second];
+        result.spans = automaton != nullptr ? findMaximalMatches(str2, *automaton, minLength)
+                                            : findMaximalMatches(str2, str1, minLength);
+    }
+    return *result.spans;
+}
+
+// Función para escribir una cadena JSON escapada
+void appendJsonString(string &out, string_view text) {
+    out.push_back('"');
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            out.append(escaped, snprintf(escaped, sizeof(escaped), "\\u%04x", c));
+        } else {
+            out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+// Función para agregar un valor binario (little endian en las plataformas soportadas)
+template <typename T>
+void appendBinary(string &out, const T &value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// Función para exportar los pares con sus métricas y coincidencias a `path`, en JSON Lines (un
+// objeto por par) o en un archivo binario por columnas. Los pares se procesan en lotes: las métricas
+// de cada lote se calculan en paralelo y se serializan en orden hacia un único escritor con búfer.
+// Formato binario: "PDPR", versión 2, si hay métricas (u32: 1 o 0), número de documentos y sus rutas
+// (longitud u32 + bytes), y bloques de pares con su número (u32; 0 termina el archivo), las columnas
+// first, second (u32), similarity (f64) y, con métricas, editDistance, containment (f64), spanCount
+// (u32) y las columnas pos1, pos2, length (u32). Con --export-metrics similarity no se calcula nada
+// por par; si no, el costo es una distancia de edición, la contención y un recorrido del autómata por
+// par. Los pares que están en `cached` (los mejores) se calculan sobre su entrada para que el reporte
+// los reutilice
+bool exportPairs(const string &path, const string &format, const Corpus &corpus, const vector<ScoredPair> &pairs,
+                 int minLength, const Options &options, vector<PairResult> &cached) {
+    BufferedSink sink;
+    if (!sink.open(path)) return false;
+    bool binary = format == "binary";
+    if (binary) {
+        string &out = sink.data();
+        out.append("PDPR", 4);
+        appendBinary<uint32_t>(out, 2);
+        appendBinary<uint32_t>(out, options.exportMetrics ? 1 : 0);
+        appendBinary<uint32_t>(out, corpus.paths.size());
+        for (const auto &documentPath : corpus.paths) {
+            appendBinary<uint32_t>(out, documentPath.size());
+            out.append(documentPath);
+        }
+        sink.commit();
+    }
+
+    const size_t batchSize = 4096;             // Pares calculados antes de serializar
+    const int chunkSize = 64;                  // Pares por tarea del planificador
+    WorkStealingScheduler scheduler(options.threads);
+    vector<SuffixAutomaton> automata(scheduler.threadCount()); // Un autómata reutilizable por hilo
+    vector<int> builtFor(scheduler.threadCount(), -1);         // Documento del autómata de cada hilo
+    vector<MetricsScratch> metricsScratch(scheduler.threadCount()); // Fila de las métricas de cada hilo
+    unordered_map<uint64_t, PairResult *> cachedByKey;         // Par (first, second) -> entrada conservada
+    for (auto &result : cached) {
+        cachedByKey[(static_cast<uint64_t>(result.first) << 32) | result.second] = &result;
+    }
+    vector<PairResult> local;                  // Resultados de los pares que no se conservan
+    vector<PairResult *> batch;                // Resultado de cada par del lote
+    for (size_t start = 0; start < pairs.size(); start += batchSize) {
+        size_t count = min(batchSize, pairs.size() - start);
+        local.assign(count, PairResult{});
+        batch.assign(count, nullptr);
+        scheduler.run((count + chunkSize - 1) / chunkSize, [&](int task, int worker) {
+            for (size_t p = task * chunkSize; p < min(count, static_cast<size_t>(task + 1) * chunkSize); ++p) {
+                const ScoredPair &pair = pairs[start + p];
+                auto found = cachedByKey.find((static_cast<uint64_t>(pair.first) << 32) | pair.second);
+                PairResult &result = found != cachedByKey.end() ? *found->second : local[p];
+                if (found == cachedByKey.end()) {
+                    result = {pair.first, pair.second, pair.similarity, nullopt, nullopt, nullopt};
+                }
+                batch[p] = &result;
+                if (!options.exportMetrics) continue;
+                completePairMetrics(result, corpus, minLength, options, metricsScratch[worker]);
+                if (!result.spans && builtFor[worker] != pair.first) { // Los pares de una misma fila comparten autómata
+                    automata[worker].build(corpus.documents[pair.first]);
+                    builtFor[worker] = pair.first;
+                }
+                pairSpans(result, corpus, minLength, &automata[worker]);
+            }
+        });
+
+        string &out = sink.data();
+        if (binary) {
+            appendBinary<uint32_t>(out, count);
+            for (const auto *result : batch) appendBinary<uint32_t>(out, result->first);
+            for (const auto *result : batch) appendBinary<uint32_t>(out, result->second);
+            for (const auto *result : batch) appendBinary<double>(out, result->similarity);
+            if (!options.exportMetrics) {
+                sink.commit();
+                continue;
+            }
+            for (const auto *result : batch) appendBinary<double>(out, *result->editDistance);
+            for (const auto *result : batch) appendBinary<double>(out, *result->containment);
+            for (const auto *result : batch) appendBinary<uint32_t>(out, result->spans->size());
+            for (const auto *result : batch) for (const auto &span : *result->spans) appendBinary<uint32_t>(out, span.pos2);
+            for (const auto *result : batch) for (const auto &span : *result->spans) appendBinary<uint32_t>(out, span.pos1);
+            for (const auto *result : batch) for (const auto &span : *result->spans) appendBinary<uint32_t>(out, span.length);
+            sink.commit();
+            continue;
+        }
+        for (const auto *pointer : batch) {
+            const PairResult &result = *pointer;
+            out.append("{\"first\":");
+            appendJsonString(out, corpus.paths[result.first]);
+            out.append(",\"second\":");
+            appendJsonString(out, corpus.paths[result.second]);
+            char numbers[128];
+            if (!options.exportMetrics) {
+                out.append(numbers, snprintf(numbers, sizeof(numbers), ",\"similarity\":%.6g}\n", result.similarity));
+                sink.commit();
+                continue;
+            }
+            out.append(numbers, snprintf(numbers, sizeof(numbers),
+                                         ",\"similarity\":%.6g,\"edit_distance\":%.17g,\"containment\":%.6g,\"spans\":[",
+                                         result.similarity, *result.editDistance, *result.containment));
+            for (size_t s = 0; s < result.spans->size(); ++s) {
+                const MatchSpan &span = (*result.spans)[s];
+                out.append(numbers, snprintf(numbers, sizeof(numbers), "%s[%d,%d,%d]", s > 0 ? "," : "",
+                                             span.pos2, span.pos1, span.length));
+            }
+            out.append("]}\n");
+            sink.commit();                     // Vacía el búfer sólo cuando se llena
+        }
+    }
+    if (binary) {
+        appendBinary<uint32_t>(sink.data(), 0); // Bloque vacío: fin del archivo
+    }
+    return sink.close();
+}
+
+// Función para dividir el corpus, en el orden de `paths`, en bloques contiguos de documentos para
+// el modo distribuido. Cada bloque de la matriz necesita en memoria los documentos de dos bloques,
+// así que cada uno se limita a la mitad de `memoryBytes`, estimando por documento su texto y sus
+// huellas; con `tileSize` > 0 los bloques tienen en cambio ese número de documentos. Devuelve el
+// inicio de cada bloque seguido del número total de documentos
+vector<int> planDocumentBlocks(const vector<string> &paths, uint64_t memoryBytes, int tileSize) {
+    const uint64_t footprint = 12;             // Bytes por byte de texto: texto, shingles del índice (8), bocetos
+    int n = paths.size();
+    vector<int> starts;
+    uint64_t used = 0;                         // Memoria estimada del bloque en construcción
+    for (int d = 0; d < n; ++d) {
+        error_code ignored;
+        uint64_t bytes = tileSize > 0 ? 0 : fs::file_size(paths[d], ignored) * footprint;
+        if (ignored) bytes = 0;                // El error se informa al leerlo
+        bool full = starts.empty() || (tileSize > 0 ? d - starts.back() == tileSize : used + bytes > memoryBytes / 2);
+        if (full) {
+            starts.push_back(d);
+            used = 0;
+        }
+        used += bytes;
+    }
+    starts.push_back(n);
+    return starts;
+}
+
+// Función para el modo distribuido (--shard i/N): el triángulo superior de la matriz se divide en
+// bloques (a, b) con a <= b entre bloques de documentos, numerados por filas, y este nodo evalúa los
+// bloques t con t % N == i. Cada bloque se carga, se evalúa y se libera antes del siguiente, así que
+// sólo hay en memoria los documentos de dos bloques. Los mejores pares (y, con --export-all, los que
+// superan --threshold) se guardan en `options.shardOutput` para combinarlos después con --merge
+int runShard(const Options &options, int minLength) {
+    vector<string> paths;
+    try {
+        paths = listCorpusFiles(options.directory, options.recursive, options.glob);
+    } catch (const fs::filesystem_error &error) {
+        cerr << "No se pudo recorrer la carpeta: " << error.what() << endl;
+        return 1;
+    }
+    vector<int> blocks = planDocumentBlocks(paths, static_cast<uint64_t>(options.shardMemory) << 20, options.tileSize);
+    int blockCount = blocks.size() - 1;
+    FingerprintConfig config;
+    config.indexLength = options.prune ? minLength : 0;
+    config.shingleLength = options.shingleLength;
+    config.sketchSize = options.sketchSize;
+    config.normalize = options.tokenize ? &options.normalize : nullptr;
+    int readerThreads = min(4, options.threads);
+
+    TopKPairs best(options.topCount);          // Mejores pares del fragmento, con índices del corpus
+    vector<ScoredPair> above;                  // Pares sobre el umbral, con índices del corpus
+    int tile = 0, assigned = 0;
+    for (int a = 0; a < blockCount; ++a) {
+        for (int b = a; b < blockCount; ++b) {
+            if (tile++ % options.shardCount != options.shardIndex) {
+                continue;                      // Bloque de otro nodo
+            }
+            assigned++;
+            vector<int> global;                // Índice en el corpus de cada documento cargado
+            for (int d = blocks[a]; d < blocks[a + 1]; ++d) global.push_back(d);
+            int split = global.size();         // Las filas son el bloque a y las columnas el b
+            if (b != a) {
+                for (int d = blocks[b]; d < blocks[b + 1]; ++d) global.push_back(d);
+            }
+            vector<string> tilePaths;
+            for (int d : global) tilePaths.push_back(paths[d]);
+
+            ScopedTimer loadTimer(RunStats::Load);
+            Corpus corpus = ingestCorpus(move(tilePaths), config, readerThreads, options.threads);
+            reportUnreadable(corpus);
+            loadTimer.stop();
+            ScopedTimer scoreTimer(RunStats::Score);
+            ShingleIndex index;
+            if (options.prune) {
+                index.build(corpus.shingles, options.minShared);
+            }
+            TopKCollector tileTop(options.topCount, options.threads);
+            vector<ScoredPair> tileAbove;
+            auto scoreTile = [&](const auto &sequences) {
+                scoreTilePairs(sequences, split, minLength, tileTop, options.exportAll ? &tileAbove : nullptr,
+                               options.threshold, options.threads, options.prune ? &index : nullptr,
+                               options.minShared, options.similarity, options.backend, options.verifySpans);
+            };
+            if (options.tokenize) {
+                scoreTile(corpus.tokenViews);
+            } else {
+                scoreTile(corpus.documents);
+            }
+            for (const auto &pair : tileTop.result()) {
+                best.push({global[pair.first], global[pair.second], pair.similarity});
+            }
+            for (const auto &pair : tileAbove) {
+                above.push_back({global[pair.first], global[pair.second], pair.similarity});
+            }
+        }
+    }
+
+    // El resultado parcial sólo incluye las rutas de los documentos que aparecen en algún par
+    ShardResult result;
+    result.shard = options.shardIndex;
+    result.shardCount = options.shardCount;
+    result.minLength = minLength;
+    result.similarity = static_cast<uint32_t>(options.similarity);
+    result.backend = static_cast<uint32_t>(options.backend);
+    result.normalization = options.tokenize ? options.normalize.key() : 0;
+    result.topCount = options.topCount;
+    result.threshold = options.threshold;
+    result.top = best.sorted();
+    result.above = move(above);
+    sort(result.above.begin(), result.above.end(), [](const ScoredPair &x, const ScoredPair &y) {
+        return x.first != y.first ? x.first < y.first : x.second < y.second;
+    });
+    vector<int> local(paths.size(), -1);       // Índice de cada documento en `result.paths`
+    for (vector<ScoredPair> *pairs : {&result.top, &result.above}) {
+        for (const auto &pair : *pairs) local[pair.first] = local[pair.second] = 0;
+    }
+    for (size_t d = 0; d < paths.size(); ++d) {
+        if (local[d] == 0) {
+            local[d] = result.paths.size();
+            result.paths.push_back(paths[d]);
+        }
+    }
+    for (vector<ScoredPair> *pairs : {&result.top, &result.above}) {
+        for (auto &pair : *pairs) pair = {local[pair.first], local[pair.second], pair.similarity};
+    }
+    if (!saveShardResult(options.shardOutput, result)) {
+        cerr << "No se pudo escribir el resultado parcial " << options.shardOutput << endl;
+        return 1;
+    }
+    cout << "Fragmento " << options.shardIndex << "/" << options.shardCount << ": " << assigned << " de " << tile
+         << " bloques de la matriz (" << blockCount << " bloques de documentos)" << endl;
+    cout << "Resultado parcial: " << result.top.size() << " mejores pares y " << result.above.size()
+         << " sobre el umbral en " << options.shardOutput << endl;
+    return 0;
+}
+
+// Función para combinar los resultados parciales de --merge. Devuelve en `paths` las rutas de los
+// documentos que aparecen en algún par, en orden, y en `topPairs` y `allPairs` los pares con índices
+// de `paths`: los `options.topCount` mejores y, con --export-all, todos los que superaron el umbral
+// en los nodos. Devuelve false si algún parcial no se puede leer o se calculó con otros parámetros
+bool mergeShardResults(const Options &options, int minLength, vector<string> &paths, vector<ScoredPair> &topPairs,
+                       vector<ScoredPair> &allPairs) {
+    vector<ShardResult> parts(options.mergePaths.size());
+    vector<bool> seen;                         // Fragmentos ya leídos
+    for (size_t p = 0; p < parts.size(); ++p) {
+        const string &file = options.mergePaths[p];
+        ShardResult &part = parts[p];
+        if (!loadShardResult(file, part)) {
+            cerr << "No se pudo leer el resultado parcial " << file << endl;
+            return false;
+        }
+        if (part.minLength != static_cast<uint32_t>(minLength) ||
+            part.similarity != static_cast<uint32_t>(options.similarity) ||
+            part.backend != static_cast<uint32_t>(options.backend) ||
+            part.normalization != (options.tokenize ? options.normalize.key() : 0) ||
+            part.threshold != options.threshold || (p > 0 && part.shardCount != parts[0].shardCount)) {
+            cerr << "El resultado parcial " << file << " se calculó con otros parámetros" << endl;
+            return false;
+        }
+        // Con menos mejores pares que los pedidos, la unión de los fragmentos ya no es el resultado exacto
+        if (part.topCount < static_cast<uint64_t>(options.topCount)) {
+            cerr << "El resultado parcial " << file << " guardó sólo " << part.topCount
+                 << " mejores pares y se pidieron " << options.topCount << " (--top)" << endl;
+            return false;
+        }
+        seen.resize(part.shardCount, false);
+        if (seen[part.shard]) {
+            cerr << "Fragmento repetido: " << part.shard << " (" << file << ")" << endl;
+            return false;
+        }
+        seen[part.shard] = true;
+        for (const auto &document : part.paths) paths.push_back(document);
+    }
+    sort(paths.begin(), paths.end());          // El mismo orden que listCorpusFiles
+    paths.erase(unique(paths.begin(), paths.end()), paths.end());
+    auto indexOf = [&](const string &document) {
+        return static_cast<int>(lower_bound(paths.begin(), paths.end(), document) - paths.begin());
+    };
+    TopKPairs best(options.topCount);
+    for (const auto &part : parts) {
+        for (const auto &pair : part.top) {
+            best.push({indexOf(part.paths[pair.first]), indexOf(part.paths[pair.second]), pair.similarity});
+        }
+        if (options.exportAll) {
+            for (const auto &pair : part.above) {
+                allPairs.push_back({indexOf(part.paths[pair.first]), indexOf(part.paths[pair.second]), pair.similarity});
+            }
+        }
+    }
+    topPairs = best.sorted();
+    sort(allPairs.begin(), allPairs.end(), [](const ScoredPair &x, const ScoredPair &y) {
+        return x.first != y.first ? x.first < y.first : x.second < y.second;
+    });
+
+    // Sólo se cargan los documentos de los pares que quedaron; el orden relativo no cambia
+    vector<int> local(paths.size(), -1);
+    for (vector<ScoredPair> *pairs : {&topPairs, &allPairs}) {
+        for (const auto &pair : *pairs) local[pair.first] = local[pair.second] = 0;
+    }
+    vector<string> kept;
+    for (size_t d = 0; d < paths.size(); ++d) {
+        if (local[d] == 0) {
+            local[d] = kept.size();
+            kept.push_back(move(paths[d]));
+        }
+    }
+    paths = move(kept);
+    for (vector<ScoredPair> *pairs : {&topPairs, &allPairs}) {
+        for (auto &pair : *pairs) pair = {local[pair.first], local[pair.second], pair.similarity};
+    }
+    size_t missing = count(seen.begin(), seen.end(), false);
+    cout << "Resultados combinados: " << parts.size() << " de " << seen.size() << " fragmentos" << endl;
+    if (missing > 0) {
+        cerr << "Faltan " << missing << " fragmentos: el resultado no cubre todos los pares" << endl;
+    }
+    return true;
+}
+
+// Función para mostrar las estadísticas de la ejecución (`print`) y/o escribirlas en JSON en
+// `jsonPath`; devuelve false si no se pudo escribir el archivo
+bool reportRunStats(double totalSeconds, bool print, const string &jsonPath) {
+    static const pair<const char *, const char *> phaseNames[RunStats::PhaseCount] = {
+        {"Carga del corpus", "load"},
+        {"Evaluación de pares", "score"},
+        {"Exportación", "export"},
+        {"Reporte HTML", "report"},
+        {"Distancia de edición (suma entre hilos)", "edit_distance"},
+        {"Contención (suma entre hilos)", "containment"}};
+    RunStats &stats = runStats();
+    vector<double> busy = stats.busy();
+    size_t peakRss = peakResidentKiB();
+    size_t arenaPeak = (MonotonicArena::globalPeak() + 1023) / 1024;
+    auto seconds = [&](int phase) { return stats.phaseNanos[phase].load() / 1e9; };
+    if (print) {
+        cout << "Estadísticas de la ejecución:" << endl << fixed << setprecision(3);
+        cout << "  Tiempo total: " << totalSeconds << " s" << endl;
+        for (int phase = 0; phase < RunStats::PhaseCount; ++phase) {
+            cout << "  " << phaseNames[phase].first << ": " << seconds(phase) << " s" << endl;
+        }
+        cout << "  Pares evaluados: " << stats.pairsScored.load() << endl;
+        if (stats.samplePairsScored.load() > 0) {
+            cout << "  Pares evaluados para estimar el recall de LSH: " << stats.samplePairsScored.load() << endl;
+        }
+        cout << "  Pares descartados: " << stats.pairsPruned.load() << endl;
+        cout << "  Bytes leídos: " << stats.bytesRead.load() << endl;
+        cout << "  Celdas DP: " << stats.dpCells.load() << endl;
+        cout << "  Pico de memoria residente: " << peakRss << " KiB" << endl;
+        cout << "  Pico de la arena por hilo: " << arenaPeak << " KiB" << endl;
+        cout << "  Tiempo ocupado por hilo:";
+        for (double value : busy) cout << " " << value;
+        cout << " s" << endl;
+    }
+    if (jsonPath.empty()) {
+        return true;
+    }
+    ofstream out(jsonPath, ios::trunc);
+    out << fixed << setprecision(6) << "{\"total_seconds\":" << totalSeconds << ",\"phases\":{";
+    for (int phase = 0; phase < RunStats::PhaseCount; ++phase) {
+        out << (phase > 0 ? "," : "") << "\"" << phaseNames[phase].second << "\":" << seconds(phase);
+    }
+    out << "},\"pairs_scored\":" << stats.pairsScored.load() << ",\"sample_pairs_scored\":"
+        << stats.samplePairsScored.load() << ",\"pairs_pruned\":" << stats.pairsPruned.load()
+        << ",\"bytes_read\":" << stats.bytesRead.load() << ",\"dp_cells\":" << stats.dpCells.load()
+        << ",\"peak_rss_kib\":" << peakRss << ",\"arena_peak_kib\":" << arenaPeak << ",\"thread_busy_seconds\":[";
+    for (size_t w = 0; w < busy.size(); ++w) {
+        out << (w > 0 ? "," : "") << busy[w];
+    }
+    out << "]}" << endl;
+    return static_cast<bool>(out);
+}
+
+} // namespace detail
+
+// Implementación de la API de biblioteca (plagiarism_detector.h) sobre el motor de detail
+
+// Estado compartido entre un ScoringJob y el hilo que lo ejecuta
+struct ScoringJob::State {
+    detail::ScoringControl control;   // Cancelación y avance de la evaluación
+};
+
+ScoringJob::ScoringJob(shared_ptr<State> state, future<ScoringResult> result)
+    : state(move(state)), result(move(result)) {}
+
+ScoringJob::~ScoringJob() {
+    if (result.valid()) {
+        cancel();                      // Nadie tomará el resultado: no tiene sentido terminarlo
+        result.wait();
+    }
+}
+
+ScoringJob &ScoringJob::operator=(ScoringJob &&other) noexcept {
+    if (this != &other) {
+        if (result.valid()) {
+            cancel();                  // Como en el destructor: el resultado reemplazado ya no se toma
+            result.wait();
+        }
+        state = move(other.state);
+        result = move(other.result);
+    }
+    return *this;
+}
+
+void ScoringJob::cancel() {
+    if (state != nullptr) {
+        state->control.cancelled = true;
+    }
+}
+
+bool ScoringJob::ready() const {
+    return result.valid() && result.wait_for(chrono::seconds(0)) == future_status::ready;
+}
+
+ScoringResult ScoringJob::get() { return result.get(); }
+
+Detector::Detector(DetectorConfig config) : config(config) {}
+
+void Detector::addText(string name, string text) {
+    names.push_back(move(name));
+    texts.push_back(make_shared<const string>(move(text)));
+}
+
+void Detector::addFile(string path) {
+    names.push_back(move(path));
+    texts.push_back(nullptr);
+}
+
+bool Detector::addDirectory(const string &directory, bool recursive, const string &glob) {
+    try {
+        for (auto &path : detail::listCorpusFiles(directory, recursive, glob)) {
+            addFile(move(path));
+        }
+    } catch (const std::filesystem::filesystem_error &) {
+        return false;
+    }
+    return true;
+}
+
+ScoringJob Detector::scoreAsync(ProgressCallback progress) const {
+    auto state = make_shared<ScoringJob::State>();
+    // El hilo trabaja sobre copias: la lista de documentos (los textos se comparten sin copiarse)
+    // y la configuración, así que el detector puede cambiar o destruirse mientras tanto
+    auto work = [state, progress, config = config, names = names, texts = texts]() mutable {
+        using namespace detail;
+        ScoringResult result;
+        ScoringControl &control = state->control;
+        int threads = config.threads > 0 ? config.threads : static_cast<int>(max(1u, thread::hardware_concurrency()));
+        if (progress) {
+            progress(Stage::Loading, 0, names.size());
+            control.progress = [&](uint64_t done, uint64_t total) { progress(Stage::Loading, done, total); };
+        }
+        NormalizeOptions normalize;
+        FingerprintConfig fingerprints;
+        fingerprints.indexLength = config.prune ? config.minLength : 0;
+        fingerprints.normalize = config.tokens ? &normalize : nullptr;
+        Corpus corpus = ingestCorpus(names, fingerprints, min(4, threads), threads, nullptr, nullptr, nullptr,
+                                     move(texts), &control);
+        result.names = move(names);
+        if (control.stopped()) {
+            result.cancelled = true;
+            return result;
+        }
+        for (size_t d = 0; d < corpus.paths.size(); ++d) {
+            if (corpus.unreadable[d]) {
+                result.error = "No se pudo leer " + corpus.paths[d];
+                return result;
+            }
+        }
+
+        if (progress) {
+            control.progress = [&](uint64_t done, uint64_t total) { progress(Stage::Scoring, done, total); };
+        }
+        ShingleIndex index;
+        if (config.prune) {
+            index.build(corpus.shingles, config.minShared);
+        }
+        TopKCollector top(config.topCount, threads);
+        SimilarityMode mode = config.coverage ? SimilarityMode::Coverage : SimilarityMode::Mass;
+        auto scoreAll = [&](const auto &sequences) {
+            generateSimilarityMatrix(sequences, config.minLength, nullptr, &top, SubstringBackend::SuffixAutomaton,
+                                     threads, config.prune ? &index : nullptr, config.minShared, false, mode, 1, 0,
+                                     &control);
+        };
+        if (config.tokens) {
+            scoreAll(corpus.tokenViews);
+        } else {
+            scoreAll(corpus.documents);
+        }
+        if (control.stopped()) {
+            result.cancelled = true;   // Los pares de una evaluación incompleta no son los K mejores
+            return result;
+        }
+        for (const auto &pair : top.result()) {
+            result.pairs.push_back({static_cast<size_t>(pair.first), static_cast<size_t>(pair.second),
+                                    pair.similarity});
+        }
+        return result;
+    };
+    return ScoringJob(state, async(launch::async, move(work)));
+}
+
+ScoringResult Detector::score(ProgressCallback progress) const { return scoreAsync(move(progress)).get(); }
+
+} // namespace plagiarism
+
+#ifndef PLAGIARISM_DETECTOR_NO_MAIN
+using namespace plagiarism::detail;
+
+int main(int argc, char *argv[]) {
+    auto runStart = chrono::steady_clock::now(); // Inicio de la ejecución, para --stats
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        cerr << "Uso: " << argv[0] << " [--backend dp|sam] [--similarity mass|coverage]"
+             << " [--containment sketch|exact|legacy]"
+             << " [--shingle-k K] [--sketch-size S] [--validate-sketch] [--verify-spans] [--max-edit T]"
+             << " [--edit-kernel dp|myers] [--verify-edit] [--bench-shingles]"
+             << " [--bench] [--bench-filter TEXTO] [--bench-csv ARCHIVO] [--bench-rate R]"
+             << " [--stats] [--stats-json ARCHIVO] [--threads N] [--block-rows R] [--block-cache KiB]"
+             << " [--min-shared N] [--no-prune] [--lsh BxR] [--lsh-sample S]"
+             << " [--storage none|auto|packed|sparse] [--threshold T] [--top K]"
+             << " [--dir DIR] [--recursive] [--glob PATRÓN] [--cache ARCHIVO]"
+             << " [--query DIR] [--top-store ARCHIVO] [--split-report DIR] [--html ARCHIVO] [--no-html]"
+             << " [--shard i/N --shard-output ARCHIVO] [--shard-memory MiB] [--tile-size N] [--merge ARCHIVO]..."
+             << " [--export ARCHIVO] [--export-format jsonl|binary] [--export-all] [--export-metrics all|similarity]"
+             << " [--tokens] [--keep-case] [--keep-punctuation] [--stopwords ARCHIVO]" << endl;
+        return 1;
+    }
+    bool merging = !options.mergePaths.empty(); // Combinar resultados parciales en lugar de evaluar pares
+    if (options.exportAll && options.shardCount == 0 && !merging &&
+        (options.storage == "none" || options.lshBands > 0 || !options.queryDirectory.empty())) {
+        cerr << "--export-all exporta la matriz guardada y requiere --storage en el modo exacto" << endl;
+        return 1;
+    }
+    if ((options.shardCount > 0 || merging) &&
+        (!options.queryDirectory.empty() || options.lshBands > 0 || (options.shardCount > 0 && merging))) {
+        cerr << "--shard y --merge no se pueden combinar entre sí ni con --query o --lsh" << endl;
+        return 1;
+    }
+    if (options.shardCount > 0 && options.shardOutput.empty()) {
+        cerr << "--shard requiere --shard-output" << endl;
+        return 1;
+    }
+    if (!options.queryDirectory.empty() && options.lshBands > 0) {
+        cerr << "--query evalúa los pares de forma exacta y no se puede combinar con --lsh" << endl;
+        return 1;
+    }
+
+    // Definimos la longitud mínima de subcadenas comunes para la comparación
+    int minLength = 5;
+
+    // Tiempos por fase y contadores de la ejecución; devuelve false si no se pudo escribir el JSON
+    auto finishStats = [&]() {
+        if (!options.stats && options.statsJsonPath.empty()) {
+            return true;
+        }
+        double totalSeconds = chrono::duration<double>(chrono::steady_clock::now() - runStart).count();
+        if (!reportRunStats(totalSeconds, options.stats, options.statsJsonPath)) {
+            cerr << "No se pudo escribir " << options.statsJsonPath << endl;
+            return false;
+        }
+        return true;
+    };
+
+    // Las pruebas de rendimiento usan textos sintéticos y no necesitan el corpus
+    if (options.benchmark) {
+        options.bench.threads = options.threads;
+        return runBenchmarks(options.bench, minLength, options.shingleLength);
+    }
+
+    // En el modo distribuido este nodo sólo evalúa sus bloques de la matriz y guarda el resultado parcial
+    if (options.shardCount > 0) {
+        int status = runShard(options, minLength);
+        return (finishStats() && status == 0) ? 0 : 1;
+    }
+
+    ScopedTimer loadTimer(RunStats::Load);
+    // Cargamos los documentos de la carpeta del corpus. Los archivos se proyectan en memoria, los
+    // documentos son vistas sobre ellos y sus huellas se calculan mientras se siguen leyendo otros
+    // En modo incremental el corpus es el archivo y las entregas nuevas se agregan al final
+    // Con --merge sólo se cargan los documentos de los pares combinados de los resultados parciales
+    vector<string> paths;
+    int archiveCount = 0;                      // Documentos del archivo (todos si no hay --query)
+    vector<ScoredPair> mergedTop, mergedAll;   // Pares combinados, con índices de `paths`
+    if (merging) {
+        if (!mergeShardResults(options, minLength, paths, mergedTop, mergedAll)) {
+            return 1;
+        }
+        archiveCount = paths.size();
+    } else {
+        try {
+            paths = listCorpusFiles(options.directory, options.recursive, options.glob);
+            archiveCount = paths.size();
+            if (!options.queryDirectory.empty()) {
+                for (auto &path : listCorpusFiles(options.queryDirectory, options.recursive, options.glob)) {
+                    paths.push_back(move(path));
+                }
+            }
+        } catch (const fs::filesystem_error &error) {
+            cerr << "No se pudo recorrer la carpeta: " << error.what() << endl;
+            return 1;
+        }
+    }
+    FingerprintConfig fingerprintConfig;
+    fingerprintConfig.indexLength = (options.prune && options.lshBands == 0 && !merging) ? minLength : 0;
+    fingerprintConfig.shingleLength = options.shingleLength;
+    fingerprintConfig.sketchSize = options.sketchSize;
+    fingerprintConfig.signatureFunctions = options.lshBands * options.lshRows;
+    fingerprintConfig.normalize = options.tokenize ? &options.normalize : nullptr;
+    int readerThreads = min(4, options.threads);
+    FingerprintCache cache;                    // Huellas de ejecuciones anteriores
+    bool useCache = !options.cachePath.empty();
+    if (useCache && !cache.load(options.cachePath, fingerprintConfig)) {
+        cache = FingerprintCache();            // Caché inexistente o incompatible: se reconstruye
+    }
+    vector<uint64_t> contentHashes;            // Hash del contenido de cada documento
+    size_t reused = 0;
+    bool needHashes = useCache || !options.topStorePath.empty(); // La caché y --top-store identifican el contenido
+    Corpus corpus = ingestCorpus(move(paths), fingerprintConfig, readerThreads, options.threads,
+                                 useCache ? &cache : nullptr, needHashes ? &contentHashes : nullptr, &reused);
+    reportUnreadable(corpus);
+    if (useCache) {
+        cout << "Caché de huellas: " << reused << " de " << corpus.documents.size() << " documentos reutilizados"
+             << endl;
+        if (reused < corpus.documents.size() || cache.size() != corpus.documents.size()) {
+            if (!FingerprintCache::save(options.cachePath, fingerprintConfig, corpus, contentHashes)) {
+                cerr << "No se pudo escribir la caché " << options.cachePath << endl;
+            }
+        }
+    }
+    loadTimer.stop();
+    const vector<string_view> &documents = corpus.documents;
+    const vector<ShingleSketch> &sketches = corpus.sketches;
+
+    // En modo de prueba sólo comparamos los núcleos de distancia de edición contra la DP y las métricas
+    // de un recorrido contra su cálculo por separado
+    if (options.verifyEdit) {
+        return verifyEditKernels(documents) + verifyPairMetrics(documents, minLength, options.shingleLength) == 0 ? 0 : 1;
+    }
+    if (options.benchShingles) {
+        return benchmarkShingles(documents, options.shingleLength) == 0 ? 0 : 1;
+    }
+
+    // Número de pares que se incluyen en el reporte
+    const size_t reportSize = options.topCount;
+    uint64_t normalization = options.tokenize ? options.normalize.key() : 0;
+
+    // Los mejores pares guardados sólo se combinan si se calcularon con los mismos parámetros y con al
+    // menos tantos mejores pares como los pedidos; si no existen, ésta es la primera ejecución
+    StoredTopPairs storedTop;
+    if (!options.queryDirectory.empty() && !options.topStorePath.empty() &&
+        filesystem::exists(options.topStorePath)) {
+        if (!loadStoredTopPairs(options.topStorePath, storedTop)) {
+            cerr << "No se pudieron leer los mejores pares guardados en " << options.topStorePath << endl;
+            return 1;
+        }
+        if (storedTop.minLength != static_cast<uint32_t>(minLength) ||
+            storedTop.similarity != static_cast<uint32_t>(options.similarity) ||
+            storedTop.normalization != normalization) {
+            cerr << "Los mejores pares de " << options.topStorePath << " se calcularon con otros parámetros" << endl;
+            return 1;
+        }
+        if (storedTop.topCount < static_cast<uint64_t>(options.topCount)) {
+            cerr << "El archivo " << options.topStorePath << " guardó sólo " << storedTop.topCount
+                 << " mejores pares y se pidieron " << options.topCount << " (--top)" << endl;
+            return 1;
+        }
+    }
+    vector<ScoredPair> topPairs;               // Pares del reporte, del más al menos similar
+    vector<ScoredPair> allPairs;               // Pares de la matriz guardada, para --export-all
+
+    // Los pares se evalúan sobre los bytes del texto o, con --tokens, sobre los identificadores de token
+    auto scorePairs = [&](const auto &sequences) {
+        if (!options.queryDirectory.empty()) {
+            // Modo incremental: sólo los pares con alguna entrega nueva, combinados con los mejores
+            // pares guardados de ejecuciones anteriores
+            ShingleIndex index;
+            if (options.prune) {
+                index.build(corpus.shingles, options.minShared);
+            }
+            TopKCollector mostSimilarPairs(reportSize, options.threads);
+            scoreQueryPairs(sequences, archiveCount, minLength, mostSimilarPairs, options.threads,
+                            options.prune ? &index : nullptr, options.minShared, options.similarity,
+                            options.backend, options.verifySpans);
+            // Un par guardado pudo volver a evaluarse en esta ejecución: se combinan por (first, second)
+            // antes de seleccionar, con la similitud recién calculada por encima de la guardada
+            unordered_map<uint64_t, double> combined;
+            auto key = [](int first, int second) {
+                return (static_cast<uint64_t>(first) << 32) | static_cast<uint32_t>(second);
+            };
+            for (const auto &pair : mostSimilarPairs.result()) {
+                combined[key(pair.first, pair.second)] = pair.similarity;
+            }
+            if (!storedTop.pairs.empty()) {
+                unordered_map<string, int> byPath;  // Índice actual de cada ruta
+                for (size_t d = 0; d < corpus.paths.size(); ++d) {
+                    byPath[corpus.paths[d]] = d;
+                }
+                vector<int> current(storedTop.paths.size(), -1); // Índice actual de cada documento guardado
+                for (size_t d = 0; d < storedTop.paths.size(); ++d) {
+                    auto found = byPath.find(storedTop.paths[d]);
+                    if (found != byPath.end()) current[d] = found->second;
+                }
+                size_t rescored = 0;
+                for (const auto &stored : storedTop.pairs) {
+                    int i = current[stored.first], j = current[stored.second];
+                    if (i < 0 || j < 0) {
+                        continue;              // Alguno de los documentos ya no está en el corpus
+                    }
+                    uint64_t pairKey = key(min(i, j), max(i, j));
+                    if (combined.count(pairKey) != 0) {
+                        continue;              // No reemplaza una similitud nueva
+                    }
+                    double similarity = stored.similarity;
+                    if (contentHashes[i] != storedTop.hashes[stored.first] ||
+                        contentHashes[j] != storedTop.hashes[stored.second]) {
+                        // El contenido cambió desde que se guardó: la similitud se vuelve a calcular
+                        similarity = similarityMetric(sequences[min(i, j)], sequences[max(i, j)], minLength,
+                                                      options.backend, options.verifySpans, options.similarity);
+                        rescored++;
+                    }
+                    combined.emplace(pairKey, similarity);
+                }
+                if (rescored > 0) {
+                    cout << "Pares guardados recalculados por cambios en sus documentos: " << rescored << endl;
+                }
+            }
+            TopKPairs merged(reportSize);
+            for (const auto &[pairKey, similarity] : combined) {
+                merged.push({static_cast<int>(pairKey >> 32), static_cast<int>(static_cast<uint32_t>(pairKey)),
+                             similarity});
+            }
+            topPairs = merged.sorted();
+            cout << "Modo incremental: " << sequences.size() - archiveCount << " entregas nuevas contra "
+                 << archiveCount << " documentos del archivo" << endl;
+        } else if (options.lshBands > 0) {
+            // Modo aproximado: firmas MinHash agrupadas por LSH y evaluación exacta sólo de los candidatos
+            vector<uint64_t> candidates = lshCandidatePairs(corpus.signatures, options.lshBands, options.lshRows);
+            topPairs = scoreCandidatePairs(sequences, candidates, minLength, reportSize, options.threads,
+                                           options.similarity, options.backend, options.verifySpans);
+            size_t totalPairs = sequences.size() * (sequences.size() - 1) / 2;
+            countStat(runStats().pairsPruned, totalPairs - candidates.size());
+            cout << "LSH " << options.lshBands << "x" << options.lshRows << ": " << candidates.size()
+                 << " pares candidatos de " << totalPairs << endl;
+            if (options.lshSample > 0) {
+                double recall = estimateLshRecall(sequences, candidates, minLength, reportSize,
+                                                  options.lshSample, options.threads, options.similarity,
+                                                  options.backend, options.verifySpans);
+                cout << "Recall estimado sobre " << min<size_t>(options.lshSample, sequences.size())
+                     << " documentos: " << fixed << setprecision(4) << recall << endl;
+            }
+        } else {
+            // Construimos el índice invertido de minLength-gramas para evaluar sólo los pares candidatos
+            ShingleIndex index;
+            if (options.prune) {
+                index.build(corpus.shingles, options.minShared);  // Shingles calculados durante la ingesta
+            }
+
+            // Generamos la matriz de similitud; los K mejores pares se seleccionan mientras se calcula,
+            // así que la matriz sólo se guarda si se pidió explícitamente con --storage
+            unique_ptr<SimilarityStorage> similarityMatrix;
+            if (options.storage != "none") {
+                similarityMatrix = makeSimilarityStorage(sequences.size(), options.storage, options.threshold);
+            }
+            TopKCollector mostSimilarPairs(reportSize, options.threads);
+            generateSimilarityMatrix(sequences, minLength, similarityMatrix.get(), &mostSimilarPairs, options.backend,
+                                     options.threads, options.prune ? &index : nullptr, options.minShared,
+                                     options.verifySpans, options.similarity, options.blockRows,
+                                     static_cast<size_t>(options.blockCache) << 10);
+            topPairs = mostSimilarPairs.result();
+            if (options.exportAll) {
+                similarityMatrix->forEachPair([&](int i, int j, double similarity) {
+                    if (similarity > options.threshold) allPairs.push_back({i, j, similarity});
+                });
+            }
+        }
+    };
+    ScopedTimer scoreTimer(RunStats::Score);
+    if (merging) {
+        topPairs = move(mergedTop);            // Los pares ya se evaluaron en los nodos
+        allPairs = move(mergedAll);
+    } else if (options.tokenize) {
+        scorePairs(corpus.tokenViews);
+    } else {
+        scorePairs(documents);
+    }
+    scoreTimer.stop();
+
+    // Guardamos los mejores pares para combinarlos en la siguiente ejecución incremental
+    if (!options.topStorePath.empty() &&
+        !saveStoredTopPairs(options.topStorePath, topPairs, corpus.paths, contentHashes, minLength,
+                            options.similarity, normalization, options.topCount)) {
+        cerr << "No se pudieron guardar los mejores pares en " << options.topStorePath << endl;
+    }
+
+    // Resultados de los mejores pares: la exportación y el reporte calculan cada métrica una sola vez
+    vector<PairResult> topResults = makePairResults(topPairs);
+
+    // Exportamos los pares con sus métricas y coincidencias para otras herramientas
+    if (!options.exportPath.empty()) {
+        ScopedTimer exportTimer(RunStats::Export);
+        if (!exportPairs(options.exportPath, options.exportFormat, corpus, options.exportAll ? allPairs : topPairs,
+                         minLength, options, topResults)) {
+            cerr << "No se pudo escribir " << options.exportPath << endl;
+            return 1;
+        }
+        cout << "Pares exportados: " << (options.exportAll ? allPairs : topPairs).size() << " en "
+             << options.exportPath << endl;
+    }
+
+    // Creamos un archivo HTML para mostrar los pares de documentos más similares (salvo --no-html)
+    ScopedTimer reportTimer(RunStats::Report);
+    bool writeHtml = !options.htmlPath.empty();
+    HtmlReportWriter report;                   // Reporte que se escribe par por par
+    if (writeHtml && !report.open(options.htmlPath, reportSize, options.reportDirectory)) {
+        cerr << "No se pudo crear el reporte HTML" << endl;
+        return 1;
+    }
+
+    double sketchError = 0.0;                  // Error absoluto acumulado de los bocetos
+    int validatedPairs = 0;                    // Pares validados contra la contención exacta
+    MetricsScratch metricsScratch;             // Fila preparada para las métricas de los pares
+
+    // Añadimos los K pares de documentos más similares al archivo HTML
+    for (size_t k = 0; k < topResults.size(); ++k) {
+        PairResult &result = topResults[k];
+        int i = result.first;                  // Índice del primer documento en el par
+        int j = result.second;                 // Índice del segundo documento en el par
+        if (options.validateSketch) {           // Validamos la estimación contra el valor exacto
+            double estimate = sketchContainment(sketches[i], sketches[j]);
+            double exact = exactContainment(corpus, i, j, options);
+            if (options.containment == ContainmentMode::Exact) {
+                result.containment = exact;    // Es la misma métrica que muestra el reporte
+            }
+            sketchError += fabs(estimate - exact);
+            validatedPairs++;
+            cout << "Par " << k + 1 << ": contención estimada " << fixed << setprecision(4) << estimate
+                 << ", exacta " << exact << endl;
+        }
+        if (!writeHtml) {
+            continue;
+        }
+
+        completePairMetrics(result, corpus, minLength, options, metricsScratch); // Las que no calculó ya la exportación
+        if (!report.writePair(k + 1, result.similarity, *result.editDistance, options.maxEditDistance,
+                              *result.containment, documents[i], documents[j], minLength,
+                              options.backend == SubstringBackend::SuffixAutomaton ? &pairSpans(result, corpus, minLength)
+                                                                                   : nullptr,
+                              options.backend)) {
+            cerr << "No se pudo escribir el par " << k + 1 << " del reporte" << endl;
+            return 1;
+        }
+    }
+
+    if (writeHtml) {
+        if (!report.close()) {                 // Cerramos el archivo HTML
+            cerr << "No se pudo escribir el reporte HTML" << endl;
+            return 1;
+        }
+        cout << "Archivo HTML generado: " << options.htmlPath << endl; // Mensaje de confirmación
+    }
+    reportTimer.stop();
+    if (validatedPairs > 0) {
+        cout << "Error absoluto medio del boceto: " << fixed << setprecision(4)
+             << sketchError / validatedPairs << endl;
+    }
+
+    if (!finishStats()) {
+        return 1;
+    }
 
     return 0;  // Fin del programa
 }
+#endif
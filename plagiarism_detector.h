@@ -0,0 +1,123 @@
+/*
+API de biblioteca del detector de plagio, para usarlo dentro de otro programa (por ejemplo, un
+servicio de calificación) sin lanzar un proceso por consulta.
+
+Un Detector acumula los documentos (archivos de una carpeta o textos en memoria) y scoreAsync
+lanza en segundo plano la carga del corpus y la evaluación de todos los pares. El trabajo devuelve
+un futuro con los mejores pares, informa su avance por un callback y se puede cancelar en cualquier
+momento: las tareas pendientes se abandonan y el resultado queda marcado como cancelado.
+
+La implementación está en main.cpp. Para compilarla como biblioteca estática, sin la función main
+de la línea de comandos:
+    g++ -std=c++17 -O2 -pthread -c -DPLAGIARISM_DETECTOR_NO_MAIN main.cpp -o plagiarism_detector.o
+    ar rcs libplagiarism_detector.a plagiarism_detector.o
+ */
+
+#ifndef PLAGIARISM_DETECTOR_H
+#define PLAGIARISM_DETECTOR_H
+
+#include <cstddef>           // Librería para size_t
+#include <cstdint>           // Librería para enteros de tamaño fijo
+#include <functional>        // Librería para std::function
+#include <future>            // Librería para std::future
+#include <memory>            // Librería para shared_ptr
+#include <string>            // Librería para manipulación de cadenas de texto
+#include <vector>            // Librería para utilizar el contenedor vector
+
+namespace plagiarism {
+
+// Parámetros de una evaluación; los valores por defecto son los de la línea de comandos
+struct DetectorConfig {
+    int minLength = 5;           // Longitud mínima de las subcadenas comunes
+    std::size_t topCount = 10;   // Pares que se devuelven
+    int threads = 0;             // Hilos de evaluación (0 = todos los del procesador)
+    int minShared = 1;           // Shingles compartidos para ser candidato
+    bool prune = true;           // Evaluar sólo los pares que comparten shingles
+    bool coverage = false;       // Similitud por cobertura en lugar de la masa de subcadenas
+    bool tokens = false;         // Comparar por tokens normalizados en lugar de bytes
+};
+
+// Par de documentos con su similitud; los índices son posiciones de ScoringResult::names
+struct PairScore {
+    std::size_t first;           // Primer documento (first < second)
+    std::size_t second;          // Segundo documento
+    double similarity;           // Similitud del par
+};
+
+// Resultado de una evaluación
+struct ScoringResult {
+    std::vector<std::string> names; // Nombre (o ruta) de cada documento, en el orden en que se agregaron
+    std::vector<PairScore> pairs;   // Mejores pares, del más al menos similar
+    bool cancelled = false;         // Se canceló antes de terminar; `pairs` queda vacío
+    std::string error;              // Descripción del error si algún archivo no se pudo leer
+};
+
+// Etapas que informa el callback de avance
+enum class Stage {
+    Loading,                     // Carga de los documentos y cálculo de sus huellas (tareas = documentos)
+    Scoring                      // Evaluación de los pares (tareas = filas de la matriz)
+};
+
+// Callback de avance: etapa, tareas terminadas y total. Se llama desde los hilos del trabajo, de
+// uno en uno, así que no necesita sincronizarse pero debe volver pronto
+using ProgressCallback = std::function<void(Stage stage, std::uint64_t done, std::uint64_t total)>;
+
+// Evaluación en curso lanzada por Detector::scoreAsync
+class ScoringJob {
+public:
+    ScoringJob(ScoringJob &&) = default;
+    ScoringJob &operator=(ScoringJob &&other) noexcept; // Cancela y espera el trabajo que se reemplaza
+    ~ScoringJob();               // Cancela el trabajo si nadie tomó su resultado y espera a que termine
+
+    // Pide detener el trabajo; durante la carga no se leen más documentos y, en la evaluación, las
+    // tareas en curso terminan su par actual. get() vuelve pronto
+    void cancel();
+
+    // Indica si el resultado ya está disponible
+    bool ready() const;
+
+    // Espera el resultado; sólo se puede llamar una vez
+    ScoringResult get();
+
+private:
+    friend class Detector;
+    struct State;                         // Estado compartido con el hilo del trabajo
+    ScoringJob(std::shared_ptr<State> state, std::future<ScoringResult> result);
+
+    std::shared_ptr<State> state;
+    std::future<ScoringResult> result;
+};
+
+// Detector de plagio: acumula documentos y evalúa sus pares en segundo plano
+class Detector {
+public:
+    explicit Detector(DetectorConfig config = DetectorConfig());
+
+    // Agrega un texto en memoria con el nombre que tendrá en los resultados
+    void addText(std::string name, std::string text);
+
+    // Agrega un archivo, que se lee al evaluar
+    void addFile(std::string path);
+
+    // Agrega los archivos de una carpeta (ordenados por ruta); devuelve false si no se pudo recorrer
+    bool addDirectory(const std::string &directory, bool recursive = false, const std::string &glob = "*");
+
+    // Número de documentos agregados
+    std::size_t documentCount() const { return names.size(); }
+
+    // Lanza la carga y la evaluación de los documentos agregados hasta ahora. El trabajo usa una
+    // copia de la lista, así que se pueden seguir agregando documentos o destruir el detector
+    ScoringJob scoreAsync(ProgressCallback progress = ProgressCallback()) const;
+
+    // Versión síncrona de scoreAsync
+    ScoringResult score(ProgressCallback progress = ProgressCallback()) const;
+
+private:
+    DetectorConfig config;
+    std::vector<std::string> names;                      // Nombre o ruta de cada documento
+    std::vector<std::shared_ptr<const std::string>> texts; // Texto en memoria (nulo = se lee de la ruta)
+};
+
+} // namespace plagiarism
+
+#endif